@@ -13,7 +13,9 @@
  *    - GET /                 → returns { "status": "online", "service": "VDJ Bridge" }
  *    - GET /search?q=QUERY   → returns a JSON array of tracks
  *    - GET /get_url?id=ID    → returns { "videoId": ..., "streamUrl": ..., ... }
- *    - (optional) /playlists and /playlist_tracks?id=... for playlist support
+ *    - (optional) /playlists and /playlist_tracks?id=...&offset=...&limit=... for playlist support
+ *    - (optional) /playlist_delta?id=...&since=SNAPSHOT to update a known playlist with only its changes
+ *    - (optional) /get_urls?ids=ID1,ID2,... to resolve many stream URLs in one request
  *
  * 2. Set the backend path:
  *    - Edit the GetBackendPath() function below to return the folder path
@@ -22,7 +24,11 @@
  *
  * 3. The plugin will attempt to auto-start the backend if not running.
  *    - It expects to find a file called main.py in the bridge path.
- *    - The backend must listen on http://127.0.0.1:8000
+ *    - The backend must listen on http://127.0.0.1:8000 (see BridgePort below)
+ *    - On Linux/macOS it may listen on a Unix domain socket instead (see
+ *      BridgeSocketPath below); the path is passed to a launched backend in
+ *      the VDJ_BRIDGE_SOCKET environment variable. The /config page is still
+ *      opened in the browser over TCP.
  *
  * 4. For backend implementation examples, see the README or use FastAPI + ytmusicapi.
  *
@@ -32,13 +38,62 @@
  * -------------------------------------------------------------------------
  * Features:
  * - Search YouTube Music
- * - Browse user playlists (with authentication)
- * - Stream audio directly (no downloads)
+ * - Browse user playlists as folders (with authentication), preloaded in the background
+ * - Stream audio through a loopback proxy that plays tracks while they download
+ * - Played tracks are kept in a size-bounded local cache
+ * - Cover images are shown in a small size and cached on disk
  * - Auto-start Python backend on load
  * - Visual feedback overlay during stream URL fetching
  */
 
+#include <string>   // for the settings below
+
 std::string BPath = "your/Path/to/bridge"; // Path to your backend bridge
+int BridgePort = 8000;                     // Port the bridge listens on (127.0.0.1)
+std::string BridgeSocketPath = "";         // Linux/macOS: reach the bridge through this Unix domain socket instead of TCP (empty = TCP)
+int LogLevel = 1;                          // Runtime log level: 0 = debug (per-track detail), 1 = info, 2 = errors only
+int MaxConcurrentRequests = 6;             // Bridge requests allowed in flight at once (decks + search + background)
+int BackgroundThreads = 2;                 // Worker threads for background work (prefetch etc.)
+int PrefetchCount = 5;                     // Stream URLs resolved ahead of time for the top search results (0 = off)
+int PlaylistResolveCount = 50;             // Stream URLs resolved in the background for the top of an opened playlist (0 = off)
+int UrlBatchWindowMs = 20;                 // Time ids are collected before a /get_urls batch is sent
+int UrlBatchMaxIds = 50;                   // Ids per /get_urls request
+int UrlBatchWaitMs = 500;                  // Longest a loaded track waits for a /get_urls batch in flight before requesting its own URL
+int SearchDebounceMs = 150;                // Quiet period before a typed query is sent to the bridge
+int SearchCacheMaxEntries = 64;            // Parsed search results kept in memory
+int SearchCacheMaxBytes = 8 * 1024 * 1024; // Memory budget for cached search results
+int SearchRevalidateAfter = 30;            // Seconds before a cached search is refreshed in the background
+int PlaylistPageSize = 200;                // Tracks per /playlist_tracks page
+int PlaylistPageParallelism = 3;           // Playlist pages fetched concurrently
+bool PlaylistProgressiveLoad = true;       // Show the first page at once and load the rest in the background
+int PlaylistCacheSeconds = 300;            // Seconds a fully loaded playlist is served from memory
+bool PlaylistStoreEnabled = true;          // Keep loaded playlists on disk and update them with /playlist_delta after a restart
+bool PlaylistWarmup = true;                // Load every playlist in the background after startup
+int PlaylistWarmupParallelism = 2;         // Playlists loaded concurrently by the warm-up
+int HealthProbeIntervalMs = 5000;          // Interval between background health probes of the bridge
+int BackendStartTimeoutMs = 20000;         // How long to wait for a freshly launched bridge to answer
+int StreamUrlDefaultTtl = 3600;            // Seconds a stream URL is trusted when neither the bridge nor the URL says otherwise
+bool AudioCacheEnabled = true;             // Download played tracks and serve them from disk as file:// URIs
+long long AudioCacheMaxBytes = 2048LL * 1024 * 1024; // Disk budget of the audio cache
+int AudioCacheMaxEntries = 4096;           // Tracks the audio cache index can hold
+int AudioCachePrefetchCount = 1;           // Top search results downloaded ahead into the audio cache (0 = off)
+int NextTrackPrefetchCount = 2;            // Tracks after a loaded one in the open playlist whose stream URLs are resolved ahead (0 = off)
+int NextTrackAudioCount = 1;               // Of those, tracks also downloaded ahead into the audio cache
+int NextTrackPrefetchThreads = 2;          // Concurrent next-track requests
+int PrefetchBandwidthKBps = 1024;          // Pace of predicted audio downloads until the track is loaded (0 = unlimited)
+bool ProgressiveProxyEnabled = true;       // Let VDJ play tracks from a loopback proxy while they download
+int ProxyPort = 0;                         // Loopback proxy port (0 = any free port)
+int ProxyStartTimeoutMs = 3000;            // Longest wait for a streamed track's first bytes before VDJ gets the remote URL instead
+bool CompactResponses = true;              // Offer the bridge the binary record format for search/playlist responses (JSON still works)
+bool LocalIndexEnabled = true;             // Remember every track seen (track_index.bin) for instant and offline search
+int LocalIndexMaxBytes = 32 * 1024 * 1024; // Size cap of the local track index
+int LocalSearchMaxResults = 50;            // Local matches shown for a search
+int FuzzyMatchPercent = 50;                // Share of a query's letter trigrams a known track needs to be offered as a near-match (0 = off)
+bool ThumbnailCacheEnabled = true;         // Keep small copies of cover images on disk and show them as file:// URIs
+int ThumbnailFetchThreads = 4;             // Cover images downloaded concurrently
+int ThumbnailSize = 120;                   // Preferred cover size in pixels (picks the nearest size the image host offers)
+long long ThumbnailCacheMaxBytes = 64LL * 1024 * 1024; // Disk budget of the cover cache
+int MetricsExportSeconds = 60;             // Interval for writing metrics.json next to plugin.log (0 = only at unload)
 
 
 #define _CRT_SECURE_NO_WARNINGS
@@ -51,19 +106,43 @@ std::string BPath = "your/Path/to/bridge"; // Path to your backend bridge
 #include <vector>
 #include <thread>
 #include <mutex>
+#include <condition_variable>
 #include <atomic>
 #include <memory>
+#include <deque>
+#include <list>
+#include <map>
+#include <iterator>
+#include <functional>
+#include <unordered_map>
+#include <unordered_set>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
 #include <sstream>
 #include <fstream>
 #include <iomanip>
 #include <cstdlib>
 #include <ctime>
+#include <cstring>
+#include <cstdint>
+#include <climits>
+#include <random>
 
 #ifdef VDJ_WIN
+#include <winsock2.h>
+#include <ws2tcpip.h>
 #include <windows.h>
+#include <mswsock.h>
 #include <Unknwn.h>
 #include <winhttp.h>
 #include <shellapi.h>
+#include <intrin.h>
+#ifdef _M_X64
+#include <immintrin.h>
+#endif
+#pragma comment(lib, "ws2_32.lib")
+#pragma comment(lib, "mswsock.lib")
 #pragma comment(lib, "winhttp.lib")
 #pragma comment(lib, "shell32.lib")
 #pragma comment(lib, "user32.lib")
@@ -71,7 +150,21 @@ std::string BPath = "your/Path/to/bridge"; // Path to your backend bridge
 #else
 #include <curl/curl.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
 #include <unistd.h>
+#include <cerrno>
+#include <signal.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#ifdef __x86_64__
+#include <immintrin.h>
+#endif
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#ifdef __linux__
+#include <sys/sendfile.h>
+#endif
 #endif
 
 
@@ -83,6 +176,7 @@ std::string BPath = "your/Path/to/bridge"; // Path to your backend bridge
 //////////////////////////////////////////////////////////////////////////
 // Forward declarations
 inline std::string GetBackendPath();
+inline std::string GetDataFilePath(const std::string& fileName);
 
 //////////////////////////////////////////////////////////////////////////
 // FeedbackOverlay - Toast-style visual feedback window
@@ -216,49 +310,500 @@ public:
 };
 #endif
 
+//////////////////////////////////////////////////////////////////////////
+// Metrics - always-on latency histograms and counters.
+// Recording is a few relaxed atomic increments with no locks and no
+// allocation, so it stays enabled in production. Histograms are log-linear
+// (HDR style): 8 sub-buckets per power of two of microseconds, about 12%
+// relative precision from 1 us up to days. Snapshot() renders everything as
+// JSON; the plugin writes it to metrics.json next to plugin.log every
+// MetricsExportSeconds and once more when it unloads. Call
+// Metrics::WriteSnapshot() for an on-demand dump.
+
+// Index of the highest set bit; v must be non-zero
+inline int HighestBit(uint64_t v) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanReverse64(&index, v);
+    return (int)index;
+#else
+    return 63 - __builtin_clzll(v);
+#endif
+}
+
+class LatencyHistogram {
+private:
+    enum {
+        SubBucketBits = 3,
+        SubBuckets = 1 << SubBucketBits,
+        BucketCount = 36 * SubBuckets
+    };
+
+    std::atomic<uint64_t> buckets[BucketCount];
+    std::atomic<uint64_t> count;
+    std::atomic<uint64_t> totalUs;
+    std::atomic<uint64_t> maxUs;
+
+    static int BucketFor(uint64_t us) {
+        if (us < SubBuckets) return (int)us;    // exact below 8 us
+        int magnitude = HighestBit(us);
+        int sub = (int)((us >> (magnitude - SubBucketBits)) & (SubBuckets - 1));
+        return std::min((magnitude - SubBucketBits + 1) * SubBuckets + sub, (int)BucketCount - 1);
+    }
+
+    // Largest value that falls into a bucket
+    static uint64_t BucketLimit(int index) {
+        if (index < SubBuckets) return (uint64_t)index;
+        int shift = index / SubBuckets - 1;
+        return ((uint64_t)(SubBuckets + index % SubBuckets + 1) << shift) - 1;
+    }
+
+public:
+    LatencyHistogram() : count(0), totalUs(0), maxUs(0) {
+        for (auto& bucket : buckets) bucket.store(0, std::memory_order_relaxed);
+    }
+
+    void Record(uint64_t us) {
+        buckets[BucketFor(us)].fetch_add(1, std::memory_order_relaxed);
+        count.fetch_add(1, std::memory_order_relaxed);
+        totalUs.fetch_add(us, std::memory_order_relaxed);
+        uint64_t seen = maxUs.load(std::memory_order_relaxed);
+        while (us > seen && !maxUs.compare_exchange_weak(seen, us, std::memory_order_relaxed)) {}
+    }
+
+    uint64_t Count() const { return count.load(std::memory_order_relaxed); }
+
+    // {"count":..,"mean_us":..,"p50_us":..,"p95_us":..,"p99_us":..,"max_us":..}
+    std::string ToJson() const {
+        uint64_t counts[BucketCount];
+        uint64_t total = 0;
+        for (int i = 0; i < BucketCount; i++) {
+            counts[i] = buckets[i].load(std::memory_order_relaxed);
+            total += counts[i];
+        }
+
+        static const double quantiles[] = { 0.50, 0.95, 0.99 };
+        uint64_t values[3] = { 0, 0, 0 };
+        uint64_t seen = 0;
+        int q = 0;
+        for (int i = 0; i < BucketCount && q < 3; i++) {
+            seen += counts[i];
+            while (q < 3 && total > 0 && seen >= (uint64_t)(quantiles[q] * total + 0.5)) {
+                values[q++] = BucketLimit(i);
+            }
+        }
+
+        // A bucket limit may overshoot the largest value actually seen
+        uint64_t max = maxUs.load(std::memory_order_relaxed);
+        for (auto& value : values) value = std::min(value, max);
+
+        uint64_t mean = total ? totalUs.load(std::memory_order_relaxed) / total : 0;
+        return "{\"count\":" + std::to_string(total) + ",\"mean_us\":" + std::to_string(mean) +
+            ",\"p50_us\":" + std::to_string(values[0]) + ",\"p95_us\":" + std::to_string(values[1]) +
+            ",\"p99_us\":" + std::to_string(values[2]) +
+            ",\"max_us\":" + std::to_string(max) + "}";
+    }
+};
+
+class Metrics {
+public:
+    enum Histogram {
+        // Bridge round-trips per endpoint
+        EndpointSearch,
+        EndpointGetUrl,
+        EndpointGetUrls,
+        EndpointPlaylists,
+        EndpointPlaylistTracks,
+        EndpointOther,
+        // Stages inside the plugin
+        StageParse,             // JSON -> Track/Playlist/stream URL
+        StageTracksAdd,         // handing results to VDJ (tracksList->add)
+        StageLog,               // formatting a log record on the calling thread
+        StageBackendStart,      // bridge launch until it answers
+        HistogramCount
+    };
+
+    enum Counter {
+        SearchCacheHits,
+        SearchCacheMisses,
+        StreamUrlCacheHits,
+        StreamUrlCacheMisses,
+        AudioCacheHits,
+        AudioCacheMisses,
+        PlaylistCacheHits,
+        PlaylistCacheMisses,
+        NextTrackHits,          // loaded tracks that had been warmed as the next in the playlist
+        NextTrackMisses,        // loaded tracks of the open playlist that had not
+        PlaylistFullBytes,      // /playlist_tracks payload bytes
+        PlaylistDeltaBytes,     // /playlist_delta payload bytes
+        PlaylistResyncs,        // deltas that could not be applied, followed by a full load
+        NotModified,            // 304 answers to conditional requests
+        Retries,
+        Timeouts,
+        Cancellations,
+        RequestErrors,          // failed bridge requests other than timeouts and cancellations
+        CoalescedRequests,      // bridge requests saved by sharing an identical one in flight
+        CounterCount
+    };
+
+private:
+    // Never freed, like the logger state, so late calls during teardown are safe
+    struct State {
+        LatencyHistogram histograms[HistogramCount];
+        std::atomic<uint64_t> counters[CounterCount];
+        std::thread exporter;
+        std::mutex exportMutex;
+        std::condition_variable exportCv;
+        bool exporting;
+
+        State() : exporting(false) {
+            for (auto& counter : counters) counter.store(0, std::memory_order_relaxed);
+        }
+    };
+
+    static State& GetState() {
+        static State* state = new State();
+        return *state;
+    }
+
+    static const char* HistogramName(int id) {
+        static const char* names[HistogramCount] = {
+            "/search", "/get_url", "/get_urls", "/playlists", "/playlist_tracks", "other_endpoints",
+            "parse", "tracks_add", "log", "backend_start"
+        };
+        return names[id];
+    }
+
+    static const char* CounterName(int id) {
+        static const char* names[CounterCount] = {
+            "search_cache_hits", "search_cache_misses", "stream_url_cache_hits", "stream_url_cache_misses",
+            "audio_cache_hits", "audio_cache_misses", "playlist_cache_hits", "playlist_cache_misses",
+            "next_track_hits", "next_track_misses", "playlist_full_bytes", "playlist_delta_bytes", "playlist_resyncs",
+            "not_modified", "retries", "timeouts", "cancellations", "request_errors", "coalesced_requests"
+        };
+        return names[id];
+    }
+
+    static void ExportLoop(std::string path, int intervalSeconds) {
+        State& state = GetState();
+        std::unique_lock<std::mutex> lock(state.exportMutex);
+        while (state.exporting) {
+            if (state.exportCv.wait_for(lock, std::chrono::seconds(intervalSeconds)) != std::cv_status::timeout) continue;
+            lock.unlock();
+            WriteSnapshot(path);
+            lock.lock();
+        }
+    }
+
+public:
+    static void Record(Histogram id, uint64_t us) {
+        GetState().histograms[id].Record(us);
+    }
+
+    static void Count(Counter id, uint64_t n = 1) {
+        GetState().counters[id].fetch_add(n, std::memory_order_relaxed);
+    }
+
+    // Histogram for a bridge endpoint ("/search?q=..." -> EndpointSearch)
+    static Histogram ForEndpoint(const std::string& endpoint) {
+        size_t end = endpoint.find('?');
+        std::string path = endpoint.substr(0, end);
+        if (path == "/search") return EndpointSearch;
+        if (path == "/get_url") return EndpointGetUrl;
+        if (path == "/get_urls") return EndpointGetUrls;
+        if (path == "/playlists") return EndpointPlaylists;
+        if (path == "/playlist_tracks") return EndpointPlaylistTracks;
+        return EndpointOther;
+    }
+
+    static std::string Snapshot() {
+        State& state = GetState();
+        std::string json = "{\"timestamp\":" + std::to_string((long long)time(nullptr)) + ",\"latency\":{";
+        for (int i = 0; i < HistogramCount; i++) {
+            if (i) json += ",";
+            json += std::string("\"") + HistogramName(i) + "\":" + state.histograms[i].ToJson();
+        }
+        json += "},\"counters\":{";
+        for (int i = 0; i < CounterCount; i++) {
+            if (i) json += ",";
+            json += std::string("\"") + CounterName(i) + "\":" +
+                std::to_string(state.counters[i].load(std::memory_order_relaxed));
+        }
+        return json + "}}\n";
+    }
+
+    // Replace the file at path with the current snapshot
+    static void WriteSnapshot(const std::string& path) {
+        std::string tempPath = path + ".tmp";
+        {
+            std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+            if (!file.is_open()) return;
+            file << Snapshot();
+        }
+        std::remove(path.c_str());
+        std::rename(tempPath.c_str(), path.c_str());
+    }
+
+    // Write a snapshot to path every intervalSeconds until StopExport()
+    static void StartExport(const std::string& path, int intervalSeconds) {
+        State& state = GetState();
+        std::lock_guard<std::mutex> lock(state.exportMutex);
+        if (state.exporting || intervalSeconds <= 0) return;
+        if (state.exporter.joinable()) state.exporter.join();
+        state.exporting = true;
+        state.exporter = std::thread(&Metrics::ExportLoop, path, intervalSeconds);
+    }
+
+    static void StopExport() {
+        State& state = GetState();
+        {
+            std::lock_guard<std::mutex> lock(state.exportMutex);
+            state.exporting = false;
+        }
+        state.exportCv.notify_all();
+        if (state.exporter.joinable()) state.exporter.join();
+    }
+};
+
+// Records the lifetime of the scope into a Metrics histogram
+class MetricTimer {
+private:
+    Metrics::Histogram id;
+    std::chrono::steady_clock::time_point start;
+
+public:
+    explicit MetricTimer(Metrics::Histogram histogram)
+        : id(histogram), start(std::chrono::steady_clock::now()) {}
+
+    ~MetricTimer() {
+        Metrics::Record(id, (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start).count());
+    }
+};
+
 //////////////////////////////////////////////////////////////////////////
 // Logging helper
+// Records are formatted on the calling thread into a fixed-size lock-free
+// ring buffer (multi-producer, single consumer) and written to plugin.log
+// in batches by a writer thread, so logging never touches the disk on a
+// VDJ thread. When the ring is full, records are dropped and counted.
+//
+// YTMUSIC_LOG_LEVEL removes lower levels at compile time; LogLevel (top of
+// file) filters at runtime. Use the YTLOG_* macros for verbose messages so
+// their arguments are not even built when the level is disabled.
+#ifndef YTMUSIC_LOG_LEVEL
+#define YTMUSIC_LOG_LEVEL 0     // 0 = debug, 1 = info, 2 = error
+#endif
+
 class Logger {
+public:
+    enum Level { LevelDebug = 0, LevelInfo = 1, LevelError = 2 };
+
 private:
+    enum {
+        RecordSize = 480,       // bytes per record, longer messages are truncated
+        RingSize = 1024,        // records, must be a power of two
+        MaxBatchBytes = 64 * 1024,
+        IdleSleepMs = 10
+    };
+
+    struct Slot {
+        std::atomic<size_t> sequence;
+        unsigned short length;
+        char text[RecordSize];
+    };
+
+    // Heap-allocated and never freed, so it outlives static destructors and
+    // any log calls made during DLL teardown
+    struct State {
+        Slot slots[RingSize];
+        std::atomic<size_t> enqueuePos;
+        size_t dequeuePos;              // only touched by the writer thread
+        std::atomic<uint64_t> dropped;
+        std::atomic<bool> running;
+        std::thread writer;
+        std::mutex lifecycleMutex;
+
+        State() : enqueuePos(0), dequeuePos(0), dropped(0), running(false) {
+            for (size_t i = 0; i < RingSize; i++) slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    };
+
+    static State& GetState() {
+        static State* state = new State();
+        return *state;
+    }
+
+    static std::atomic<int>& RuntimeLevel() {
+        static std::atomic<int> level(LogLevel);
+        return level;
+    }
+
     static std::string GetLogPath() {
-        std::string backendPath = GetBackendPath();
-        return backendPath + "\\plugin.log";
+        return GetDataFilePath("plugin.log");
     }
 
-    static std::string GetTimestamp() {
+    static size_t FormatTimestamp(char* buf, size_t size) {
         time_t now = time(0);
         struct tm tstruct;
-        char buf[80];
+#ifdef VDJ_WIN
         localtime_s(&tstruct, &now);
-        strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", &tstruct);
-        return buf;
+#else
+        localtime_r(&now, &tstruct);
+#endif
+        return strftime(buf, size, "%Y-%m-%d %H:%M:%S", &tstruct);
     }
 
-public:
-    static void Log(const std::string& message) {
-        std::string logMsg = "[" + GetTimestamp() + "] " + message;
-        
+    static void Enqueue(Level level, const char* message, size_t length) {
+        State& state = GetState();
+        size_t pos = state.enqueuePos.load(std::memory_order_relaxed);
+        Slot* slot;
+        for (;;) {
+            slot = &state.slots[pos & (RingSize - 1)];
+            size_t seq = slot->sequence.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+            if (diff == 0) {
+                if (state.enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (diff < 0) {
+                state.dropped.fetch_add(1, std::memory_order_relaxed);  // ring full
+                return;
+            } else {
+                pos = state.enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+
+        // "[timestamp] ERROR: message\n"
+        char* out = slot->text;
+        size_t used = 0;
+        out[used++] = '[';
+        used += FormatTimestamp(out + used, RecordSize - used);
+        out[used++] = ']';
+        out[used++] = ' ';
+        if (level == LevelError) {
+            memcpy(out + used, "ERROR: ", 7);
+            used += 7;
+        }
+        size_t room = RecordSize - used - 1;
+        if (length > room) length = room;
+        memcpy(out + used, message, length);
+        used += length;
+        out[used++] = '\n';
+        slot->length = (unsigned short)used;
+        slot->sequence.store(pos + 1, std::memory_order_release);
+    }
+
+    // Move every committed record into batch; returns the number drained
+    static size_t Drain(State& state, std::string& batch) {
+        size_t count = 0;
+        while (batch.size() < MaxBatchBytes) {
+            Slot& slot = state.slots[state.dequeuePos & (RingSize - 1)];
+            size_t seq = slot.sequence.load(std::memory_order_acquire);
+            if ((intptr_t)seq - (intptr_t)(state.dequeuePos + 1) < 0) break;   // not yet committed
+            batch.append(slot.text, slot.length);
+            slot.sequence.store(state.dequeuePos + RingSize, std::memory_order_release);
+            state.dequeuePos++;
+            count++;
+        }
+        return count;
+    }
+
+    static void WriteBatch(FILE*& file, const std::string& batch) {
+        if (batch.empty()) return;
 #ifdef VDJ_WIN
-        // Output to debugger
-        OutputDebugStringA(("[YTMusic] " + logMsg + "\n").c_str());
+        OutputDebugStringA(batch.c_str());
 #endif
-        
-        // Write to log file
-        std::ofstream logFile(GetLogPath(), std::ios::app);
-        if (logFile.is_open()) {
-            logFile << logMsg << std::endl;
-            logFile.close();
+        if (!file) file = fopen(GetLogPath().c_str(), "ab");
+        if (file) {
+            fwrite(batch.data(), 1, batch.size(), file);
+            fflush(file);
+        }
+    }
+
+    static void WriterLoop() {
+        State& state = GetState();
+        FILE* file = nullptr;
+        std::string batch;
+        batch.reserve(MaxBatchBytes + RecordSize);
+        uint64_t reportedDrops = 0;
+
+        for (;;) {
+            bool keepRunning = state.running.load(std::memory_order_acquire);
+            batch.clear();
+            size_t drained = Drain(state, batch);
+
+            uint64_t drops = state.dropped.load(std::memory_order_relaxed);
+            if (drops != reportedDrops) {
+                batch += "[logger] " + std::to_string(drops - reportedDrops) + " records dropped (ring full)\n";
+                reportedDrops = drops;
+            }
+            WriteBatch(file, batch);
+
+            if (drained == 0) {
+                if (!keepRunning) break;
+                std::this_thread::sleep_for(std::chrono::milliseconds(IdleSleepMs));
+            }
         }
+        if (file) fclose(file);
+    }
+
+    static void EnsureWriter() {
+        State& state = GetState();
+        if (state.running.load(std::memory_order_acquire)) return;
+        std::lock_guard<std::mutex> lock(state.lifecycleMutex);
+        if (state.running.load(std::memory_order_relaxed)) return;
+        if (state.writer.joinable()) state.writer.join();
+        state.running.store(true, std::memory_order_release);
+        state.writer = std::thread(&Logger::WriterLoop);
+    }
+
+public:
+    static bool IsEnabled(Level level) {
+        return level >= YTMUSIC_LOG_LEVEL && level >= RuntimeLevel().load(std::memory_order_relaxed);
+    }
+
+    static void SetLevel(Level level) {
+        RuntimeLevel().store(level, std::memory_order_relaxed);
+    }
+
+    static void Write(Level level, const std::string& message) {
+        if (!IsEnabled(level)) return;
+        MetricTimer timer(Metrics::StageLog);
+        EnsureWriter();
+        Enqueue(level, message.data(), message.size());
+    }
+
+    static void Debug(const std::string& message) {
+        Write(LevelDebug, message);
+    }
+
+    static void Log(const std::string& message) {
+        Write(LevelInfo, message);
     }
 
     static void Error(const std::string& message) {
-        Log("ERROR: " + message);
+        Write(LevelError, message);
 #ifdef VDJ_WIN
         MessageBoxA(NULL, message.c_str(), "YouTube Music Plugin Error", MB_OK | MB_ICONERROR);
 #endif
     }
+
+    static uint64_t DroppedRecords() {
+        return GetState().dropped.load(std::memory_order_relaxed);
+    }
+
+    // Flush pending records and stop the writer thread (restarts on next log)
+    static void Shutdown() {
+        State& state = GetState();
+        std::lock_guard<std::mutex> lock(state.lifecycleMutex);
+        state.running.store(false, std::memory_order_release);
+        if (state.writer.joinable()) state.writer.join();
+    }
 };
 
+// Verbose logging: the message expression is only evaluated when enabled
+#define YTLOG_DEBUG(expr) \
+    do { if (YTMUSIC_LOG_LEVEL <= 0 && Logger::IsEnabled(Logger::LevelDebug)) Logger::Debug(expr); } while (0)
+
 //////////////////////////////////////////////////////////////////////////
 // Helper class for HTTP requests
 // Get backend directory path - points to Desktop/vdj_plugin_ytmusic/bridge
@@ -267,6 +812,15 @@ inline std::string GetBackendPath() {
     return BPath;
 }
 
+// Path of a file the plugin keeps next to plugin.log in the backend folder
+inline std::string GetDataFilePath(const std::string& fileName) {
+#ifdef VDJ_WIN
+    return GetBackendPath() + "\\" + fileName;
+#else
+    return GetBackendPath() + "/" + fileName;
+#endif
+}
+
 //////////////////////////////////////////////////////////////////////////
 // Simple JSON parser (minimal implementation)
 class SimpleJSON {
@@ -355,322 +909,5449 @@ public:
 };
 
 //////////////////////////////////////////////////////////////////////////
-// Helper class for HTTP requests
-class HttpClient {
+// Streaming JSON reader - single pass pull tokenizer over a response buffer.
+// Keys are compared in place against literals and string values are decoded
+// straight into the caller's std::string, so nothing is allocated per key.
+class JsonReader {
+public:
+    enum Token {
+        BeginObject, EndObject, BeginArray, EndArray,
+        Key, String, Number, True, False, Null,
+        End, Error
+    };
+
 private:
-    std::string baseUrl;
-    
-#ifdef VDJ_WIN
-    HINTERNET hSession;
-    HINTERNET hConnect;
-#else
-    CURL* curl;
-#endif
+    static const int MaxDepth = 64;
 
-    static size_t WriteCallback(void* contents, size_t size, size_t nmemb, void* userp) {
-        ((std::string*)userp)->append((char*)contents, size * nmemb);
-        return size * nmemb;
+    const char* pos;
+    const char* end;
+    const char* tokBegin;   // for Key/String: first char after the opening quote
+    const char* tokEnd;     // for Key/String: the closing quote
+    bool tokEscaped;
+    double number;
+    char stack[MaxDepth];
+    int depth;
+    bool expectKey;
+    std::string scratch;    // decoded key, only used for keys containing escapes
+
+    void ValueDone() {
+        if (depth > 0 && stack[depth - 1] == '{') expectKey = true;
     }
 
-public:
-    HttpClient() : baseUrl("http://127.0.0.1:8000") {
-#ifdef VDJ_WIN
-        hSession = WinHttpOpen(L"VDJ-YTMusic/1.0",
-            WINHTTP_ACCESS_TYPE_DEFAULT_PROXY,
-            WINHTTP_NO_PROXY_NAME,
-            WINHTTP_NO_PROXY_BYPASS, 0);
-        if (hSession) {
-            hConnect = WinHttpConnect(hSession, L"127.0.0.1", 8000, 0);
+    static int HexValue(char c) {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    }
+
+    static bool ReadHex4(const char*& p, const char* limit, unsigned& out) {
+        if (limit - p < 4) return false;
+        out = 0;
+        for (int i = 0; i < 4; i++) {
+            int v = HexValue(p[i]);
+            if (v < 0) return false;
+            out = (out << 4) | (unsigned)v;
         }
-#else
-        curl_global_init(CURL_GLOBAL_DEFAULT);
-        curl = curl_easy_init();
-#endif
+        p += 4;
+        return true;
     }
 
-    ~HttpClient() {
-#ifdef VDJ_WIN
-        if (hConnect) WinHttpCloseHandle(hConnect);
-        if (hSession) WinHttpCloseHandle(hSession);
-#else
-        if (curl) curl_easy_cleanup(curl);
-        curl_global_cleanup();
-#endif
+    static void AppendUtf8(std::string& out, unsigned cp) {
+        if (cp < 0x80) {
+            out += (char)cp;
+        } else if (cp < 0x800) {
+            out += (char)(0xC0 | (cp >> 6));
+            out += (char)(0x80 | (cp & 0x3F));
+        } else if (cp < 0x10000) {
+            out += (char)(0xE0 | (cp >> 12));
+            out += (char)(0x80 | ((cp >> 6) & 0x3F));
+            out += (char)(0x80 | (cp & 0x3F));
+        } else {
+            out += (char)(0xF0 | (cp >> 18));
+            out += (char)(0x80 | ((cp >> 12) & 0x3F));
+            out += (char)(0x80 | ((cp >> 6) & 0x3F));
+            out += (char)(0x80 | (cp & 0x3F));
+        }
     }
 
-    std::string Get(const std::string& endpoint) {
-        std::string response;
-        
-#ifdef VDJ_WIN
-        if (!hConnect) return "";
-        
-        std::wstring wEndpoint(endpoint.begin(), endpoint.end());
-        HINTERNET hRequest = WinHttpOpenRequest(hConnect, L"GET",
-            wEndpoint.c_str(), NULL, WINHTTP_NO_REFERER,
-            WINHTTP_DEFAULT_ACCEPT_TYPES, 0);
-        
-        if (hRequest) {
-            if (WinHttpSendRequest(hRequest, WINHTTP_NO_ADDITIONAL_HEADERS, 0,
-                WINHTTP_NO_REQUEST_DATA, 0, 0, 0) &&
-                WinHttpReceiveResponse(hRequest, NULL)) {
-                
-                DWORD dwSize = 0;
-                DWORD dwDownloaded = 0;
-                do {
-                    dwSize = 0;
-                    if (WinHttpQueryDataAvailable(hRequest, &dwSize) && dwSize > 0) {
-                        char* buffer = new char[dwSize + 1];
-                        ZeroMemory(buffer, dwSize + 1);
-                        
-                        if (WinHttpReadData(hRequest, buffer, dwSize, &dwDownloaded)) {
-                            response.append(buffer, dwDownloaded);
+    // Decode an escaped JSON string body [begin, limit) and append it to out
+    static void Unescape(const char* p, const char* limit, std::string& out) {
+        while (p < limit) {
+            const char* run = p;
+            while (p < limit && *p != '\\') p++;
+            out.append(run, p - run);
+            if (p >= limit) break;
+            if (++p >= limit) break;
+            char c = *p++;
+            switch (c) {
+            case 'b': out += '\b'; break;
+            case 'f': out += '\f'; break;
+            case 'n': out += '\n'; break;
+            case 'r': out += '\r'; break;
+            case 't': out += '\t'; break;
+            case 'u': {
+                unsigned cp;
+                if (!ReadHex4(p, limit, cp)) { out += '?'; break; }
+                if (cp >= 0xD800 && cp <= 0xDBFF) {
+                    // High surrogate, expect a following \uDC00-\uDFFF
+                    unsigned lo;
+                    const char* q = p;
+                    if (limit - q >= 2 && q[0] == '\\' && q[1] == 'u') {
+                        q += 2;
+                        if (ReadHex4(q, limit, lo) && lo >= 0xDC00 && lo <= 0xDFFF) {
+                            cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+                            p = q;
+                        } else {
+                            cp = 0xFFFD;
                         }
-                        delete[] buffer;
+                    } else {
+                        cp = 0xFFFD;
                     }
-                } while (dwSize > 0);
+                } else if (cp >= 0xDC00 && cp <= 0xDFFF) {
+                    cp = 0xFFFD;
+                }
+                AppendUtf8(out, cp);
+                break;
+            }
+            default: out += c; break; // \" \\ \/ and anything unknown
             }
-            WinHttpCloseHandle(hRequest);
         }
-#else
-        if (!curl) return "";
-        
-        std::string url = baseUrl + endpoint;
-        curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
-        curl_easy_setopt(curl, CURLOPT_TIMEOUT, 30L);
-        
-        CURLcode res = curl_easy_perform(curl);
-        if (res != CURLE_OK) {
-            return "";
+    }
+
+    Token ScanString() {
+        const char* p = ++pos;
+        bool escaped = false;
+        while (p < end && *p != '"') {
+            if (*p == '\\') {
+                escaped = true;
+                if (++p >= end) break;
+            }
+            p++;
         }
-#endif
-        
-        return response;
+        if (p >= end) return Error;
+        tokBegin = pos;
+        tokEnd = p;
+        tokEscaped = escaped;
+        pos = p + 1;
+
+        if (expectKey && depth > 0 && stack[depth - 1] == '{') {
+            expectKey = false;
+            return Key;
+        }
+        ValueDone();
+        return String;
     }
 
-    bool IsServerAlive() {
-        std::string response = Get("/");
-        bool alive = !response.empty() && response.find("\"status\"") != std::string::npos;
-        if (alive) {
-            Logger::Log("HttpClient: Server is alive");
-        } else {
-            Logger::Log("HttpClient: Server not responding");
+    Token ScanNumber() {
+        const char* p = pos;
+        bool negative = false;
+        if (*p == '-' || *p == '+') { negative = (*p == '-'); p++; }
+        double value = 0.0;
+        while (p < end && *p >= '0' && *p <= '9') value = value * 10.0 + (*p++ - '0');
+        if (p < end && *p == '.') {
+            double scale = 0.1;
+            for (p++; p < end && *p >= '0' && *p <= '9'; p++, scale *= 0.1) value += (*p - '0') * scale;
         }
-        return alive;
+        if (p < end && (*p == 'e' || *p == 'E')) {
+            p++;
+            bool negExp = false;
+            if (p < end && (*p == '-' || *p == '+')) { negExp = (*p == '-'); p++; }
+            // Anything past 400 already over/underflows a double; clamping keeps the
+            // accumulator from overflowing and the scaling loop bounded
+            int exp = 0;
+            for (; p < end && *p >= '0' && *p <= '9'; p++) if (exp < 400) exp = exp * 10 + (*p - '0');
+            if (exp > 400) exp = 400;
+            while (exp-- > 0) value = negExp ? value / 10.0 : value * 10.0;
+        }
+        if (p == pos) return Error;
+        number = negative ? -value : value;
+        pos = p;
+        ValueDone();
+        return Number;
     }
 
-    bool IsAuthenticated() {
-        std::string response = Get("/auth_status");
-        if (response.empty()) return false;
-        bool auth = SimpleJSON::ExtractBool(response, "authenticated");
-        Logger::Log(std::string("HttpClient: Authenticated = ") + (auth ? "true" : "false"));
-        return auth;
+    Token ScanLiteral(const char* word, size_t len, Token tok) {
+        if ((size_t)(end - pos) < len || memcmp(pos, word, len) != 0) return Error;
+        pos += len;
+        ValueDone();
+        return tok;
     }
-};
 
-//////////////////////////////////////////////////////////////////////////
-// Track data structure
-struct Track {
-    std::string videoId;
-    std::string title;
-    std::string artist;
-    std::string album;
-    float duration;
-    std::string thumbnail;
-    bool isVideo;
-};
+public:
+    JsonReader(const char* data, size_t size)
+        : pos(data), end(data + size), tokBegin(data), tokEnd(data),
+          tokEscaped(false), number(0.0), depth(0), expectKey(false) {}
 
-//////////////////////////////////////////////////////////////////////////
-// Playlist data structure
-struct Playlist {
-    std::string playlistId;
-    std::string title;
-    int count;
-    std::string thumbnail;
-};
+    explicit JsonReader(const std::string& json) : JsonReader(json.data(), json.size()) {}
 
-//////////////////////////////////////////////////////////////////////////
-// Main plugin class
-class YouTubeMusicPlugin : public IVdjPluginOnlineSource {
-private:
-    HttpClient httpClient;
-    FeedbackOverlay feedback;
-    std::vector<Track> searchResults;
-    std::vector<Playlist> userPlaylists;
-    std::vector<Track> currentPlaylistTracks;
-    std::string currentFolder;
-    bool backendRunning;
-    HANDLE pythonProcess;
-    std::mutex dataMutex;
-    bool authPromptShown = false;
+    Token Next() {
+        while (pos < end) {
+            char c = *pos;
+            if (c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == ',' || c == ':') {
+                pos++;
+                continue;
+            }
+            switch (c) {
+            case '{':
+            case '[':
+                if (depth >= MaxDepth) return Error;
+                stack[depth++] = c;
+                expectKey = (c == '{');
+                pos++;
+                return c == '{' ? BeginObject : BeginArray;
+            case '}':
+            case ']':
+                if (depth == 0) return Error;
+                depth--;
+                pos++;
+                ValueDone();
+                return c == '}' ? EndObject : EndArray;
+            case '"':
+                return ScanString();
+            case 't': return ScanLiteral("true", 4, True);
+            case 'f': return ScanLiteral("false", 5, False);
+            case 'n': return ScanLiteral("null", 4, Null);
+            default:
+                if (c == '-' || c == '+' || (c >= '0' && c <= '9')) return ScanNumber();
+                return Error;
+            }
+        }
+        return End;
+    }
 
-    void OpenConfigPageIfNeeded() {
-    if (authPromptShown) return;
+    // Skip the remainder of a value whose first token was just returned
+    bool Skip(Token first) {
+        if (first != BeginObject && first != BeginArray) return first != Error && first != End;
+        int target = depth - 1;
+        while (depth > target) {
+            Token t = Next();
+            if (t == Error || t == End) return false;
+        }
+        return true;
+    }
+
+    // Advance to the first array in the document (top level or nested in a wrapper object)
+    bool SeekArray() {
+        for (;;) {
+            Token t = Next();
+            if (t == BeginArray) return true;
+            if (t == Error || t == End) return false;
+        }
+    }
+
+    // Compare the current Key token against a literal without allocating
+    bool KeyIs(const char* literal, size_t len) {
+        if (!tokEscaped) {
+            return (size_t)(tokEnd - tokBegin) == len && memcmp(tokBegin, literal, len) == 0;
+        }
+        scratch.clear();
+        Unescape(tokBegin, tokEnd, scratch);
+        return scratch.size() == len && memcmp(scratch.data(), literal, len) == 0;
+    }
+
+    template <size_t N>
+    bool KeyIs(const char (&literal)[N]) { return KeyIs(literal, N - 1); }
+
+    // Decode the current Key/String token into out (reusing its capacity)
+    void ReadString(std::string& out) const {
+        out.clear();
+        AppendString(out);
+    }
+
+    // Decode the current Key/String token onto the end of out
+    void AppendString(std::string& out) const {
+        if (tokEscaped) Unescape(tokBegin, tokEnd, out);
+        else out.append(tokBegin, tokEnd - tokBegin);
+    }
+
+    bool StringIs(const char* literal, size_t len) const {
+        return !tokEscaped && (size_t)(tokEnd - tokBegin) == len && memcmp(tokBegin, literal, len) == 0;
+    }
+
+    double NumberValue() const { return number; }
+
+    // Interpret a scalar value token as a number (accepts quoted numbers)
+    double AsNumber(Token t) const {
+        if (t == Number) return number;
+        if (t == String) {
+            JsonReader inner(tokBegin, tokEnd - tokBegin);
+            if (inner.Next() == Number) return inner.NumberValue();
+        }
+        return 0.0;
+    }
+
+    // Interpret a scalar value token as an int; NaN and out-of-range values become 0
+    int AsInt(Token t) const {
+        double value = AsNumber(t);
+        if (!(value > -2147483648.0 && value < 2147483648.0)) return 0;
+        return (int)value;
+    }
+
+    // Interpret a scalar value token as a bool (accepts "true"/"True")
+    bool AsBool(Token t) const {
+        if (t == True) return true;
+        if (t == String) return StringIs("true", 4) || StringIs("True", 4);
+        return false;
+    }
+};
+
+//////////////////////////////////////////////////////////////////////////
+// Compact record format ("application/x-ytm-records") - what the bridge may
+// send instead of JSON for /search, /playlists and /playlist_tracks when the
+// request's Accept header offers it. Little-endian throughout:
+//   header    "YTMR", u8 version (1), u8 kind (1 = tracks, 2 = playlists),
+//             u16 reserved, u32 total (0xFFFFFFFF = unknown), u32 count
+//   track     str videoId, str title, str artist, str album, str thumbnail,
+//             u32 duration (seconds), u8 flags (bit 0 = isVideo)
+//   playlist  str playlistId, str title, str thumbnail, u32 count
+//   str       u16 byte length, then that many UTF-8 bytes
+// Every string arrives with its length, so decoding is a bounds check and a
+// copy per field; nothing is scanned or unescaped.
+class RecordReader {
+private:
+    const unsigned char* begin;
+    const unsigned char* pos;
+    const unsigned char* end;
+
+public:
+    enum Kind { KindTracks = 1, KindPlaylists = 2 };
+    enum { Version = 1, HeaderSize = 16, MinTrackSize = 5 * 2 + 5, MinPlaylistSize = 3 * 2 + 4 };
+
+    static const char* ContentType() { return "application/x-ytm-records"; }
+
+    // True if a response body is in this format rather than JSON
+    static bool Matches(const std::string& body) {
+        return body.size() >= HeaderSize && memcmp(body.data(), "YTMR", 4) == 0;
+    }
+
+    explicit RecordReader(const std::string& body)
+        : begin((const unsigned char*)body.data()), pos(begin), end(begin + body.size()) {}
+
+    RecordReader(const char* data, size_t size)
+        : begin((const unsigned char*)data), pos(begin), end(begin + size) {}
+
+    // Bytes consumed so far
+    size_t Offset() const { return (size_t)(pos - begin); }
+
+    bool ReadU8(uint8_t& out) {
+        if (end - pos < 1) return false;
+        out = *pos++;
+        return true;
+    }
+
+    bool ReadU16(uint16_t& out) {
+        if (end - pos < 2) return false;
+        out = (uint16_t)(pos[0] | (pos[1] << 8));
+        pos += 2;
+        return true;
+    }
+
+    bool ReadU32(uint32_t& out) {
+        if (end - pos < 4) return false;
+        out = (uint32_t)pos[0] | ((uint32_t)pos[1] << 8) | ((uint32_t)pos[2] << 16) | ((uint32_t)pos[3] << 24);
+        pos += 4;
+        return true;
+    }
+
+    // Point data/size at the next string in the buffer (not NUL-terminated)
+    bool ReadString(const char*& data, size_t& size) {
+        uint16_t length;
+        if (!ReadU16(length) || end - pos < length) return false;
+        data = (const char*)pos;
+        size = length;
+        pos += length;
+        return true;
+    }
+
+    bool ReadString(std::string& out) {
+        const char* data;
+        size_t size;
+        if (!ReadString(data, size)) return false;
+        out.assign(data, size);
+        return true;
+    }
+
+    // Check the header; total is -1 when the bridge did not send one
+    bool ReadHeader(Kind kind, int& total, uint32_t& count) {
+        if (end - pos < HeaderSize || memcmp(pos, "YTMR", 4) != 0) return false;
+        pos += 4;
+        uint8_t version = 0, bodyKind = 0;
+        uint16_t reserved = 0;
+        uint32_t rawTotal = 0;
+        if (!ReadU8(version) || !ReadU8(bodyKind) || !ReadU16(reserved) ||
+            !ReadU32(rawTotal) || !ReadU32(count)) return false;
+        if (version != Version || bodyKind != kind) return false;
+        total = rawTotal == 0xFFFFFFFFu || rawTotal > (uint32_t)INT_MAX ? -1 : (int)rawTotal;
+
+        // Reject counts the remaining bytes cannot hold before reserving for them
+        size_t minSize = kind == KindTracks ? MinTrackSize : MinPlaylistSize;
+        return count <= (size_t)(end - pos) / minSize;
+    }
+};
+
+//////////////////////////////////////////////////////////////////////////
+// CancelToken - shared flag used to abort in-flight HTTP requests.
+// HttpClient registers a cancel action while a request is running (closing
+// the WinHTTP request handle); curl requests poll the flag from callbacks.
+class CancelToken {
+private:
+    std::atomic<bool> cancelled;
+    std::mutex mutex;
+    std::function<void()> action;
+    bool actionRan;
+
+public:
+    CancelToken() : cancelled(false), actionRan(false) {}
+
+    void Cancel() {
+        std::lock_guard<std::mutex> lock(mutex);
+        cancelled = true;
+        if (action && !actionRan) {
+            actionRan = true;
+            action();
+        }
+    }
+
+    bool IsCancelled() const {
+        return cancelled;
+    }
+
+    // Install the action run by Cancel(). Returns false if already cancelled.
+    bool SetCancelAction(std::function<void()> cancelAction) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (cancelled) return false;
+        action = std::move(cancelAction);
+        actionRan = false;
+        return true;
+    }
+
+    // Remove the action. Returns true if Cancel() already ran it.
+    bool ClearCancelAction() {
+        std::lock_guard<std::mutex> lock(mutex);
+        action = nullptr;
+        return actionRan;
+    }
+};
+
+typedef std::shared_ptr<CancelToken> CancelTokenPtr;
+
+//////////////////////////////////////////////////////////////////////////
+// Per-request options for HttpClient
+struct HttpRequestOptions {
+    long timeoutMs;         // total time allowed for the request
+    long connectTimeoutMs;  // time allowed to connect to the bridge
+    bool background;        // speculative work: waits while foreground requests are active
+    CancelTokenPtr cancel;  // optional; cancelling aborts the request and Get() returns ""
+    std::string ifNoneMatch;        // conditional request validators (see HttpValidators)
+    std::string ifModifiedSince;
+    std::string range;              // byte range "first-last" or "first-" (DownloadUrl only)
+    bool compact;                   // accept the binary record format (see RecordReader)
+
+    HttpRequestOptions() : timeoutMs(30000), connectTimeoutMs(2000), background(false), compact(false) {}
+    explicit HttpRequestOptions(long timeout) : timeoutMs(timeout), connectTimeoutMs(2000), background(false), compact(false) {}
+};
+
+//////////////////////////////////////////////////////////////////////////
+// Status, body and cache validators of a bridge response. status is 0 when
+// the request failed or was cancelled.
+struct HttpResponse {
+    long status;
+    std::string body;
+    std::string etag;
+    std::string lastModified;
+    long long contentLength;    // Content-Length, -1 if absent
+    long long rangeTotal;       // resource size from Content-Range, -1 if absent
+
+    HttpResponse() : status(0), contentLength(-1), rangeTotal(-1) {}
+    bool NotModified() const { return status == 304; }
+
+    // Size of the whole resource (not just this range), -1 if unknown
+    long long ResourceLength() const { return status == 206 ? rangeTotal : contentLength; }
+
+    // Record a Content-Length or Content-Range ("bytes 0-99/1234") header
+    void SetLengthHeader(bool isRange, const std::string& value) {
+        if (!isRange) {
+            if (!value.empty()) contentLength = strtoll(value.c_str(), nullptr, 10);
+            return;
+        }
+        size_t slash = value.find('/');
+        if (slash != std::string::npos && value[slash + 1] != '*') {
+            rangeTotal = strtoll(value.c_str() + slash + 1, nullptr, 10);
+        }
+    }
+};
+
+// FNV-1a over a response body, used to detect unchanged payloads
+inline uint64_t HashBytes(const char* data, size_t size) {
+    uint64_t hash = 1469598103934665603ULL;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= (unsigned char)data[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Validators stored with cached parsed data. ETag/Last-Modified are sent back
+// as If-None-Match/If-Modified-Since so an unchanged resource costs a 304
+// with no body. The body hash catches unchanged payloads from bridges that
+// send no validators, so at least the parse is skipped.
+struct HttpValidators {
+    std::string etag;
+    std::string lastModified;
+    uint64_t bodyHash;
+
+    HttpValidators() : bodyHash(0) {}
+
+    static HttpValidators From(const HttpResponse& response) {
+        HttpValidators v;
+        v.etag = response.etag;
+        v.lastModified = response.lastModified;
+        v.bodyHash = HashBytes(response.body.data(), response.body.size());
+        return v;
+    }
+
+    void Apply(HttpRequestOptions& options) const {
+        options.ifNoneMatch = etag;
+        options.ifModifiedSince = lastModified;
+    }
+
+    // True if a 200 response carries the same payload we already parsed
+    bool SameBody(const HttpResponse& response) const {
+        return bodyHash != 0 && HashBytes(response.body.data(), response.body.size()) == bodyHash;
+    }
+};
+
+//////////////////////////////////////////////////////////////////////////
+// Helper class for HTTP requests
+// Thread-safe: any number of threads may call Get() concurrently. Up to
+// MaxConcurrentRequests requests are in flight at once; further callers wait
+// for a free slot. Connections to the bridge are kept alive and reused.
+// Background requests only start while no foreground request is active and
+// never take more than half of the slots. Identical requests made at the
+// same time share one round-trip (see Request).
+class HttpClient {
+private:
+    // A bridge request in flight that identical requests can wait for
+    struct Flight {
+        bool background;
+        bool started;       // past the priority gate
+        bool done;
+        bool cancelled;     // the leading caller's token aborted it
+        HttpResponse response;
+
+        explicit Flight(bool isBackground) : background(isBackground), started(false), done(false), cancelled(false) {}
+    };
+    typedef std::shared_ptr<Flight> FlightPtr;
+
+    std::string baseUrl;
+    std::string socketPath;     // Unix domain socket of the bridge, empty for TCP
+    int maxInFlight;
+    int maxBackground;
+    int foregroundActive;
+    int backgroundActive;
+    std::mutex priorityMutex;
+    std::condition_variable priorityCv;
+    std::mutex flightMutex;
+    std::condition_variable flightCv;
+    std::unordered_map<std::string, FlightPtr> flights;     // by FlightKey
+
+#ifdef VDJ_WIN
+    HINTERNET hSession;
+    HINTERNET hConnect;
+    int inFlight;
+#else
+    // Easy handles are pooled; DNS cache, TLS sessions and the connection
+    // cache live in a share handle so every pooled handle reuses them.
+    CURLSH* share;
+    std::mutex shareLocks[CURL_LOCK_DATA_LAST];
+    std::vector<CURL*> idleHandles;
+    int createdHandles;
+#endif
+    std::mutex poolMutex;
+    std::condition_variable poolCv;
+
+    // Holds the foreground/background accounting for the duration of a
+    // request. A background request waits for its turn only until its
+    // timeoutMs runs out or it is cancelled (checked every 50 ms); Acquired()
+    // is false then and the request must not be sent.
+    class PriorityScope {
+        HttpClient& owner;
+        bool background;
+        bool acquired;
+
+        bool Ready() const {
+            return owner.foregroundActive == 0 && owner.backgroundActive < owner.maxBackground;
+        }
+
+    public:
+        PriorityScope(HttpClient& client, const HttpRequestOptions& options)
+            : owner(client), background(options.background), acquired(true) {
+            std::unique_lock<std::mutex> lock(owner.priorityMutex);
+            if (!background) {
+                owner.foregroundActive++;
+                return;
+            }
+
+            CancelToken* cancel = options.cancel.get();
+            bool timed = options.timeoutMs > 0;
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(options.timeoutMs);
+            while (!Ready()) {
+                if (cancel && cancel->IsCancelled()) {
+                    acquired = false;
+                    return;
+                }
+                auto wake = std::chrono::steady_clock::now() + std::chrono::milliseconds(50);
+                if (timed && wake >= deadline) {
+                    if (owner.priorityCv.wait_until(lock, deadline) == std::cv_status::timeout && !Ready()) {
+                        acquired = false;
+                        return;
+                    }
+                } else {
+                    owner.priorityCv.wait_until(lock, wake);
+                }
+            }
+            owner.backgroundActive++;
+        }
+        ~PriorityScope() {
+            if (!acquired) return;
+            {
+                std::lock_guard<std::mutex> lock(owner.priorityMutex);
+                if (background) owner.backgroundActive--;
+                else owner.foregroundActive--;
+            }
+            owner.priorityCv.notify_all();
+        }
+
+        bool Acquired() const {
+            return acquired;
+        }
+    };
+
+    // Requests with the same key get the same answer from the bridge
+    static std::string FlightKey(const std::string& endpoint, const HttpRequestOptions& options) {
+        return endpoint + '\n' + AcceptHeader(options) + '\n' + options.ifNoneMatch + '\n' + options.ifModifiedSince;
+    }
+
+    void MarkStarted(Flight& flight) {
+        std::lock_guard<std::mutex> lock(flightMutex);
+        flight.started = true;
+    }
+
+    // Accept header for a bridge request: the record format first when
+    // allowed, JSON otherwise. Bodies may be gzip/deflate compressed either way.
+    static std::string AcceptHeader(const HttpRequestOptions& options) {
+        if (options.compact && CompactResponses) {
+            return std::string("Accept: ") + RecordReader::ContentType() + ", application/json;q=0.5";
+        }
+        return "Accept: application/json";
+    }
+
+    static size_t WriteCallback(void* contents, size_t size, size_t nmemb, void* userp) {
+        ((std::string*)userp)->append((char*)contents, size * nmemb);
+        return size * nmemb;
+    }
+
+#ifndef VDJ_WIN
+    // Captures ETag / Last-Modified response headers
+    static size_t HeaderCallback(char* buffer, size_t size, size_t nitems, void* userp) {
+        size_t length = size * nitems;
+        HttpResponse* result = (HttpResponse*)userp;
+        std::string line(buffer, length);
+        size_t colon = line.find(':');
+        if (colon != std::string::npos) {
+            std::string name = line.substr(0, colon);
+            for (auto& c : name) c = (char)tolower((unsigned char)c);
+            size_t valueStart = line.find_first_not_of(" \t", colon + 1);
+            size_t valueEnd = line.find_last_not_of(" \t\r\n");
+            std::string value = (valueStart == std::string::npos || valueEnd < valueStart)
+                ? std::string() : line.substr(valueStart, valueEnd - valueStart + 1);
+            if (name == "etag") result->etag = value;
+            else if (name == "last-modified") result->lastModified = value;
+            else if (name == "content-length") result->SetLengthHeader(false, value);
+            else if (name == "content-range") result->SetLengthHeader(true, value);
+        } else if (line.compare(0, 5, "HTTP/") == 0) {
+            // Status line of a new response (e.g. after a redirect)
+            *result = HttpResponse();
+        }
+        return length;
+    }
+
+    // Returning non-zero makes curl abort the transfer with CURLE_ABORTED_BY_CALLBACK
+    static int XferInfoCallback(void* userp, curl_off_t, curl_off_t, curl_off_t, curl_off_t) {
+        return ((CancelToken*)userp)->IsCancelled() ? 1 : 0;
+    }
+#endif
+
+#ifndef VDJ_WIN
+    static void ShareLock(CURL*, curl_lock_data data, curl_lock_access, void* userp) {
+        ((HttpClient*)userp)->shareLocks[data].lock();
+    }
+
+    static void ShareUnlock(CURL*, curl_lock_data data, void* userp) {
+        ((HttpClient*)userp)->shareLocks[data].unlock();
+    }
+
+    CURL* AcquireHandle() {
+        std::unique_lock<std::mutex> lock(poolMutex);
+        poolCv.wait(lock, [this] { return !idleHandles.empty() || createdHandles < maxInFlight; });
+        if (!idleHandles.empty()) {
+            CURL* handle = idleHandles.back();
+            idleHandles.pop_back();
+            return handle;
+        }
+        CURL* handle = curl_easy_init();
+        if (handle) createdHandles++;
+        return handle;
+    }
+
+    void ReleaseHandle(CURL* handle) {
+        {
+            std::lock_guard<std::mutex> lock(poolMutex);
+            idleHandles.push_back(handle);
+        }
+        poolCv.notify_one();
+    }
+#else
+    static std::string QueryHeader(HINTERNET hRequest, DWORD query) {
+        wchar_t buffer[256];
+        DWORD size = sizeof(buffer);
+        if (!WinHttpQueryHeaders(hRequest, query, WINHTTP_HEADER_NAME_BY_INDEX, buffer, &size, WINHTTP_NO_HEADER_INDEX)) {
+            return "";
+        }
+        std::wstring value(buffer, size / sizeof(wchar_t));
+        return std::string(value.begin(), value.end());
+    }
+
+    void AcquireSlot() {
+        std::unique_lock<std::mutex> lock(poolMutex);
+        poolCv.wait(lock, [this] { return inFlight < maxInFlight; });
+        inFlight++;
+    }
+
+    void ReleaseSlot() {
+        {
+            std::lock_guard<std::mutex> lock(poolMutex);
+            inFlight--;
+        }
+        poolCv.notify_one();
+    }
+#endif
+
+public:
+    HttpClient() : baseUrl("http://127.0.0.1:" + std::to_string(BridgePort)), maxInFlight(MaxConcurrentRequests > 0 ? MaxConcurrentRequests : 1),
+        foregroundActive(0), backgroundActive(0) {
+        maxBackground = maxInFlight / 2 > 0 ? maxInFlight / 2 : 1;
+#ifdef VDJ_WIN
+        inFlight = 0;
+        hConnect = NULL;
+        hSession = WinHttpOpen(L"VDJ-YTMusic/1.0",
+            WINHTTP_ACCESS_TYPE_DEFAULT_PROXY,
+            WINHTTP_NO_PROXY_NAME,
+            WINHTTP_NO_PROXY_BYPASS, 0);
+        if (hSession) {
+            // WinHTTP keeps connections alive per session; allow one per slot
+            DWORD maxConns = (DWORD)maxInFlight;
+            WinHttpSetOption(hSession, WINHTTP_OPTION_MAX_CONNS_PER_SERVER, &maxConns, sizeof(maxConns));
+            hConnect = WinHttpConnect(hSession, L"127.0.0.1", (INTERNET_PORT)BridgePort, 0);
+        }
+#else
+        socketPath = BridgeSocketPath;
+        createdHandles = 0;
+        curl_global_init(CURL_GLOBAL_DEFAULT);
+        share = curl_share_init();
+        if (share) {
+            curl_share_setopt(share, CURLSHOPT_LOCKFUNC, ShareLock);
+            curl_share_setopt(share, CURLSHOPT_UNLOCKFUNC, ShareUnlock);
+            curl_share_setopt(share, CURLSHOPT_USERDATA, this);
+            curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+            curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+            curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+        }
+#endif
+    }
+
+    ~HttpClient() {
+#ifdef VDJ_WIN
+        if (hConnect) WinHttpCloseHandle(hConnect);
+        if (hSession) WinHttpCloseHandle(hSession);
+#else
+        for (CURL* handle : idleHandles) curl_easy_cleanup(handle);
+        idleHandles.clear();
+        if (share) curl_share_cleanup(share);
+        curl_global_cleanup();
+#endif
+    }
+
+    std::string Get(const std::string& endpoint) {
+        return Get(endpoint, HttpRequestOptions());
+    }
+
+    // Response body regardless of status; "" on transport failure or cancellation
+    std::string Get(const std::string& endpoint, const HttpRequestOptions& options) {
+        return Request(endpoint, options).body;
+    }
+
+    // Send a GET to the bridge. A caller asking for what is already in flight
+    // (same endpoint, Accept and validators) waits for that request and gets
+    // its response instead of sending another. Foreground callers do not
+    // wait for a background request that has not started yet. If the
+    // leading caller cancels, the others send the request again. Every
+    // caller keeps its own timeoutMs: a waiter whose time runs out gets an
+    // empty response, as if its own request had timed out.
+    HttpResponse Request(const std::string& endpoint, const HttpRequestOptions& options) {
+        std::string key = FlightKey(endpoint, options);
+        CancelToken* cancel = options.cancel.get();
+        bool timed = options.timeoutMs > 0;
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(options.timeoutMs);
+        for (bool retry = false;; retry = true) {
+            FlightPtr flight;
+            bool leading = false;
+            {
+                std::lock_guard<std::mutex> lock(flightMutex);
+                auto it = flights.find(key);
+                if (it != flights.end() && (options.background || !it->second->background || it->second->started)) {
+                    flight = it->second;
+                } else {
+                    // New, or only a queued background one: this caller sends it
+                    flight = std::make_shared<Flight>(options.background);
+                    flights[key] = flight;
+                    leading = true;
+                }
+            }
+
+            if (leading) {
+                HttpResponse response;
+                if (retry && timed) {
+                    // Sent again after a cancelled leader: only the time left
+                    auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+                    HttpRequestOptions remaining = options;
+                    remaining.timeoutMs = std::max(1L, (long)left.count());
+                    response = Perform(endpoint, remaining, *flight);
+                } else {
+                    response = Perform(endpoint, options, *flight);
+                }
+                {
+                    std::lock_guard<std::mutex> lock(flightMutex);
+                    flight->response = response;
+                    flight->cancelled = cancel && cancel->IsCancelled();
+                    flight->done = true;
+                    auto it = flights.find(key);
+                    if (it != flights.end() && it->second == flight) flights.erase(it);
+                }
+                flightCv.notify_all();
+                return response;
+            }
+
+            std::unique_lock<std::mutex> lock(flightMutex);
+            while (!flight->done) {
+                if (cancel && cancel->IsCancelled()) return HttpResponse();
+                auto wake = std::chrono::steady_clock::now() + std::chrono::milliseconds(50);
+                if (timed && wake >= deadline) {
+                    if (flightCv.wait_until(lock, deadline) == std::cv_status::timeout && !flight->done) return HttpResponse();
+                } else {
+                    flightCv.wait_until(lock, wake);
+                }
+            }
+            if (flight->cancelled && flight->response.status == 0) continue;
+            Metrics::Count(Metrics::CoalescedRequests);
+            return flight->response;
+        }
+    }
+
+private:
+    HttpResponse Perform(const std::string& endpoint, const HttpRequestOptions& options, Flight& flight) {
+        HttpResponse result;
+        std::string& response = result.body;
+        CancelToken* cancel = options.cancel.get();
+        PriorityScope priority(*this, options);
+        MarkStarted(flight);
+        if (!priority.Acquired()) {
+            Metrics::Count(cancel && cancel->IsCancelled() ? Metrics::Cancellations : Metrics::Timeouts);
+            return HttpResponse();
+        }
+        if (cancel && cancel->IsCancelled()) return HttpResponse();
+        MetricTimer timer(Metrics::ForEndpoint(endpoint));
+        
+#ifdef VDJ_WIN
+        if (!hConnect) return HttpResponse();
+
+        AcquireSlot();
+        
+        std::wstring wEndpoint(endpoint.begin(), endpoint.end());
+        HINTERNET hRequest = WinHttpOpenRequest(hConnect, L"GET",
+            wEndpoint.c_str(), NULL, WINHTTP_NO_REFERER,
+            WINHTTP_DEFAULT_ACCEPT_TYPES, 0);
+
+        // Closing the request handle from another thread aborts the blocking calls below
+        if (hRequest && cancel && !cancel->SetCancelAction([hRequest] { WinHttpCloseHandle(hRequest); })) {
+            WinHttpCloseHandle(hRequest);
+            hRequest = NULL;
+        }
+        
+        if (hRequest) {
+            int timeout = (int)options.timeoutMs;
+            WinHttpSetTimeouts(hRequest, timeout, (int)options.connectTimeoutMs, timeout, timeout);
+
+            // Sends Accept-Encoding: gzip, deflate and inflates the body transparently
+            DWORD decompression = WINHTTP_DECOMPRESSION_FLAG_ALL;
+            WinHttpSetOption(hRequest, WINHTTP_OPTION_DECOMPRESSION, &decompression, sizeof(decompression));
+
+            std::string headers = AcceptHeader(options) + "\r\n";
+            if (!options.ifNoneMatch.empty()) headers += "If-None-Match: " + options.ifNoneMatch + "\r\n";
+            if (!options.ifModifiedSince.empty()) headers += "If-Modified-Since: " + options.ifModifiedSince + "\r\n";
+            std::wstring wHeaders(headers.begin(), headers.end());
+
+            if (WinHttpSendRequest(hRequest,
+                wHeaders.empty() ? WINHTTP_NO_ADDITIONAL_HEADERS : wHeaders.c_str(),
+                wHeaders.empty() ? 0 : (DWORD)-1L,
+                WINHTTP_NO_REQUEST_DATA, 0, 0, 0) &&
+                WinHttpReceiveResponse(hRequest, NULL)) {
+
+                DWORD status = 0;
+                DWORD statusSize = sizeof(status);
+                WinHttpQueryHeaders(hRequest, WINHTTP_QUERY_STATUS_CODE | WINHTTP_QUERY_FLAG_NUMBER,
+                    WINHTTP_HEADER_NAME_BY_INDEX, &status, &statusSize, WINHTTP_NO_HEADER_INDEX);
+                result.status = (long)status;
+                result.etag = QueryHeader(hRequest, WINHTTP_QUERY_ETAG);
+                result.lastModified = QueryHeader(hRequest, WINHTTP_QUERY_LAST_MODIFIED);
+                
+                DWORD dwSize = 0;
+                DWORD dwDownloaded = 0;
+                do {
+                    dwSize = 0;
+                    if (WinHttpQueryDataAvailable(hRequest, &dwSize) && dwSize > 0) {
+                        size_t offset = response.size();
+                        response.resize(offset + dwSize);
+                        dwDownloaded = 0;
+                        WinHttpReadData(hRequest, &response[offset], dwSize, &dwDownloaded);
+                        response.resize(offset + dwDownloaded);
+                    }
+                } while (dwSize > 0);
+            } else if (GetLastError() == ERROR_WINHTTP_TIMEOUT) {
+                Metrics::Count(Metrics::Timeouts);
+            } else if (!(cancel && cancel->IsCancelled())) {
+                Metrics::Count(Metrics::RequestErrors);
+            }
+            bool closedByCancel = cancel && cancel->ClearCancelAction();
+            if (!closedByCancel) WinHttpCloseHandle(hRequest);
+        }
+
+        ReleaseSlot();
+#else
+        CURL* curl = AcquireHandle();
+        if (!curl) return HttpResponse();
+        
+        std::string url = baseUrl + endpoint;
+        curl_easy_reset(curl);
+        curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
+        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
+        curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, HeaderCallback);
+        curl_easy_setopt(curl, CURLOPT_HEADERDATA, &result);
+        curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, options.timeoutMs);
+        curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT_MS, options.connectTimeoutMs);
+        curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);   // required for timeouts on worker threads
+        curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+        curl_easy_setopt(curl, CURLOPT_ACCEPT_ENCODING, "");   // every encoding curl can inflate
+        if (!socketPath.empty()) curl_easy_setopt(curl, CURLOPT_UNIX_SOCKET_PATH, socketPath.c_str());
+        if (share) curl_easy_setopt(curl, CURLOPT_SHARE, share);
+        if (cancel) {
+            curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
+            curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, XferInfoCallback);
+            curl_easy_setopt(curl, CURLOPT_XFERINFODATA, cancel);
+        }
+
+        struct curl_slist* headers = curl_slist_append(nullptr, AcceptHeader(options).c_str());
+        if (!options.ifNoneMatch.empty()) headers = curl_slist_append(headers, ("If-None-Match: " + options.ifNoneMatch).c_str());
+        if (!options.ifModifiedSince.empty()) headers = curl_slist_append(headers, ("If-Modified-Since: " + options.ifModifiedSince).c_str());
+        if (headers) curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+        
+        CURLcode res = curl_easy_perform(curl);
+        curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &result.status);
+        ReleaseHandle(curl);
+        if (headers) curl_slist_free_all(headers);
+        if (res != CURLE_OK) {
+            if (res == CURLE_OPERATION_TIMEDOUT) Metrics::Count(Metrics::Timeouts);
+            else if (cancel && cancel->IsCancelled()) Metrics::Count(Metrics::Cancellations);
+            else Metrics::Count(Metrics::RequestErrors);
+            return HttpResponse();
+        }
+#endif
+        
+        if (cancel && cancel->IsCancelled()) {
+            Metrics::Count(Metrics::Cancellations);
+            return HttpResponse();
+        }
+        if (result.NotModified()) Metrics::Count(Metrics::NotModified);
+        return result;
+    }
+
+public:
+    // Cheap health probe; the caller (BackendMonitor) logs state changes
+    bool IsServerAlive(long timeoutMs = 2000) {
+        std::string response = Get("/", HttpRequestOptions(timeoutMs));
+        return !response.empty() && response.find("\"status\"") != std::string::npos;
+    }
+
+    bool IsAuthenticated() {
+        std::string response = Get("/auth_status", HttpRequestOptions(5000));
+        if (response.empty()) return false;
+        bool auth = SimpleJSON::ExtractBool(response, "authenticated");
+        Logger::Log(std::string("HttpClient: Authenticated = ") + (auth ? "true" : "false"));
+        return auth;
+    }
+
+    // Receives each chunk of a download; return false to abort the transfer
+    typedef std::function<bool(const char* data, size_t size)> DataSink;
+
+    // Bridge address for a browser; always TCP, whatever transport requests use
+    const std::string& BaseUrl() const { return baseUrl; }
+
+    // How requests reach the bridge, for the log
+    std::string TransportName() const {
+        if (!socketPath.empty()) return "unix:" + socketPath;
+        return "tcp:" + baseUrl.substr(baseUrl.find("//") + 2);
+    }
+
+    // Download an absolute URL (the media host a stream URL points at, not the
+    // bridge) and hand the body to sink chunk by chunk. Does not use the bridge
+    // connection slots. timeoutMs = 0 means no overall limit. If response is
+    // given, its status and headers are filled in before the first chunk
+    // reaches sink. Returns true if the whole body was received with a 2xx status.
+    bool DownloadUrl(const std::string& url, const HttpRequestOptions& options, const DataSink& sink,
+                     HttpResponse* response = nullptr) {
+        HttpResponse head;
+        if (!response) response = &head;
+        *response = HttpResponse();
+        CancelToken* cancel = options.cancel.get();
+        if (cancel && cancel->IsCancelled()) return false;
+
+#ifdef VDJ_WIN
+        if (!hSession) return false;
+
+        std::wstring wUrl(url.begin(), url.end());
+        std::vector<wchar_t> host(256), path(wUrl.size() + 1), extra(wUrl.size() + 1);
+        URL_COMPONENTS parts;
+        ZeroMemory(&parts, sizeof(parts));
+        parts.dwStructSize = sizeof(parts);
+        parts.lpszHostName = host.data();
+        parts.dwHostNameLength = (DWORD)host.size();
+        parts.lpszUrlPath = path.data();
+        parts.dwUrlPathLength = (DWORD)path.size();
+        parts.lpszExtraInfo = extra.data();
+        parts.dwExtraInfoLength = (DWORD)extra.size();
+        if (!WinHttpCrackUrl(wUrl.c_str(), 0, 0, &parts)) return false;
+
+        std::wstring object = std::wstring(path.data(), parts.dwUrlPathLength) +
+            std::wstring(extra.data(), parts.dwExtraInfoLength);
+        HINTERNET hHost = WinHttpConnect(hSession, host.data(), parts.nPort, 0);
+        if (!hHost) return false;
+
+        HINTERNET hRequest = WinHttpOpenRequest(hHost, L"GET", object.c_str(), NULL,
+            WINHTTP_NO_REFERER, WINHTTP_DEFAULT_ACCEPT_TYPES,
+            parts.nScheme == INTERNET_SCHEME_HTTPS ? WINHTTP_FLAG_SECURE : 0);
+        if (hRequest && cancel && !cancel->SetCancelAction([hRequest] { WinHttpCloseHandle(hRequest); })) {
+            WinHttpCloseHandle(hRequest);
+            hRequest = NULL;
+        }
+
+        bool ok = false;
+        if (hRequest) {
+            int timeout = options.timeoutMs > 0 ? (int)options.timeoutMs : 60000;
+            WinHttpSetTimeouts(hRequest, timeout, (int)options.connectTimeoutMs, timeout, timeout);
+
+            std::wstring headers;
+            if (!options.range.empty()) {
+                headers = L"Range: bytes=" + std::wstring(options.range.begin(), options.range.end()) + L"\r\n";
+            }
+            if (WinHttpSendRequest(hRequest, headers.empty() ? WINHTTP_NO_ADDITIONAL_HEADERS : headers.c_str(),
+                headers.empty() ? 0 : (DWORD)-1L, WINHTTP_NO_REQUEST_DATA, 0, 0, 0) &&
+                WinHttpReceiveResponse(hRequest, NULL)) {
+                DWORD status = 0;
+                DWORD statusSize = sizeof(status);
+                WinHttpQueryHeaders(hRequest, WINHTTP_QUERY_STATUS_CODE | WINHTTP_QUERY_FLAG_NUMBER,
+                    WINHTTP_HEADER_NAME_BY_INDEX, &status, &statusSize, WINHTTP_NO_HEADER_INDEX);
+                response->status = (long)status;
+                response->etag = QueryHeader(hRequest, WINHTTP_QUERY_ETAG);
+                response->lastModified = QueryHeader(hRequest, WINHTTP_QUERY_LAST_MODIFIED);
+                response->SetLengthHeader(false, QueryHeader(hRequest, WINHTTP_QUERY_CONTENT_LENGTH));
+                response->SetLengthHeader(true, QueryHeader(hRequest, WINHTTP_QUERY_CONTENT_RANGE));
+
+                ok = status >= 200 && status < 300;
+                std::vector<char> buffer(64 * 1024);
+                while (ok) {
+                    DWORD read = 0;
+                    if (!WinHttpReadData(hRequest, buffer.data(), (DWORD)buffer.size(), &read)) {
+                        ok = false;
+                        break;
+                    }
+                    if (read == 0) break;   // end of body
+                    if (!sink(buffer.data(), read)) ok = false;
+                }
+            }
+            bool closedByCancel = cancel && cancel->ClearCancelAction();
+            if (!closedByCancel) WinHttpCloseHandle(hRequest);
+        }
+        WinHttpCloseHandle(hHost);
+        return ok && !(cancel && cancel->IsCancelled());
+#else
+        CURL* curl = curl_easy_init();
+        if (!curl) return false;
+
+        struct SinkState {
+            const DataSink* sink;
+            CURL* curl;
+            HttpResponse* response;
+            static size_t Write(void* contents, size_t size, size_t nmemb, void* userp) {
+                SinkState* state = (SinkState*)userp;
+                if (state->response->status == 0) {
+                    curl_easy_getinfo(state->curl, CURLINFO_RESPONSE_CODE, &state->response->status);
+                }
+                return (*state->sink)((const char*)contents, size * nmemb) ? size * nmemb : 0;
+            }
+        } state = { &sink, curl, response };
+
+        curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, SinkState::Write);
+        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &state);
+        curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, HeaderCallback);
+        curl_easy_setopt(curl, CURLOPT_HEADERDATA, response);
+        if (!options.range.empty()) curl_easy_setopt(curl, CURLOPT_RANGE, options.range.c_str());
+        curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+        curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, options.timeoutMs);
+        curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT_MS, options.connectTimeoutMs);
+        // Give up on stalled transfers instead of holding the download slot forever
+        curl_easy_setopt(curl, CURLOPT_LOW_SPEED_LIMIT, 1L);
+        curl_easy_setopt(curl, CURLOPT_LOW_SPEED_TIME, 30L);
+        curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+        if (share) curl_easy_setopt(curl, CURLOPT_SHARE, share);
+        if (cancel) {
+            curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
+            curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, XferInfoCallback);
+            curl_easy_setopt(curl, CURLOPT_XFERINFODATA, cancel);
+        }
+
+        CURLcode res = curl_easy_perform(curl);
+        curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response->status);
+        curl_easy_cleanup(curl);
+        return res == CURLE_OK && response->status >= 200 && response->status < 300;
+#endif
+    }
+};
+
+//////////////////////////////////////////////////////////////////////////
+// Track data structure
+// TrackTable - parsed tracks as rows of offsets into one string arena.
+// Strings are stored NUL-terminated so the const char* the VDJ API takes
+// points straight into the arena. A table parsed from a response reserves
+// the arena up front (decoded strings never outgrow the JSON they came
+// from), so a response costs a couple of allocations instead of several
+// per track, and re-emitting a list walks contiguous memory. Tables are
+// shared read-only (TrackTablePtr) once built.
+class TrackTable {
+public:
+    struct Row {
+        uint32_t videoId;       // arena offsets; 0 is the empty string
+        uint32_t title;
+        uint32_t artist;
+        uint32_t album;
+        uint32_t thumbnail;
+        float duration;
+        bool isVideo;
+    };
+
+private:
+    std::string arena;
+    std::vector<Row> rows;
+
+public:
+    TrackTable() : arena(1, '\0') {}
+
+    void Reserve(size_t arenaBytes, size_t rowCount) {
+        arena.reserve(arena.size() + arenaBytes);
+        rows.reserve(rows.size() + rowCount);
+    }
+
+    // Give back reserved space that went unused by more than a quarter
+    void ShrinkToFit() {
+        if (arena.capacity() > arena.size() + arena.size() / 4) arena.shrink_to_fit();
+        if (rows.capacity() > rows.size() + rows.size() / 4) rows.shrink_to_fit();
+    }
+
+    // Strings are written by appending to Arena() from `start = ArenaSize()`
+    // and sealed with EndString(start), which returns the string's offset
+    std::string& Arena() { return arena; }
+    size_t ArenaSize() const { return arena.size(); }
+
+    uint32_t EndString(size_t start) {
+        if (arena.size() == start) return 0;
+        arena.push_back('\0');
+        return (uint32_t)start;
+    }
+
+    uint32_t AddString(const char* data, size_t size) {
+        size_t start = arena.size();
+        arena.append(data, size);
+        return EndString(start);
+    }
+
+    // Drop strings written after `size` (e.g. those of a rejected row)
+    void TruncateArena(size_t size) { arena.resize(size); }
+
+    // Remove all rows, keeping the allocated space for reuse
+    void Clear() {
+        arena.assign(1, '\0');
+        rows.clear();
+    }
+
+    void AddRow(const Row& row) { rows.push_back(row); }
+
+    // Append one row of another table
+    void AppendRow(const TrackTable& other, const Row& row) {
+        Row copy = row;
+        uint32_t* fields[] = { &copy.videoId, &copy.title, &copy.artist, &copy.album, &copy.thumbnail };
+        for (uint32_t* field : fields) {
+            if (*field) {
+                const char* text = other.Str(*field);
+                *field = AddString(text, strlen(text));
+            }
+        }
+        rows.push_back(copy);
+    }
+
+    // Append all rows of another table
+    void Append(const TrackTable& other) {
+        uint32_t base = (uint32_t)arena.size() - 1;     // skip other's leading empty string
+        arena.append(other.arena, 1, std::string::npos);
+        for (Row row : other.rows) {
+            uint32_t* fields[] = { &row.videoId, &row.title, &row.artist, &row.album, &row.thumbnail };
+            for (uint32_t* field : fields) {
+                if (*field) *field += base;
+            }
+            rows.push_back(row);
+        }
+    }
+
+    size_t Size() const { return rows.size(); }
+    bool Empty() const { return rows.empty(); }
+    const Row& operator[](size_t i) const { return rows[i]; }
+    std::vector<Row>::const_iterator begin() const { return rows.begin(); }
+    std::vector<Row>::const_iterator end() const { return rows.end(); }
+
+    const char* Str(uint32_t offset) const { return arena.c_str() + offset; }
+
+    // Memory held by the table, for cache budgets
+    size_t Bytes() const { return sizeof(*this) + arena.capacity() + rows.capacity() * sizeof(Row); }
+};
+
+typedef std::shared_ptr<const TrackTable> TrackTablePtr;
+
+// Read one binary track record (see RecordReader) into tracks. A record
+// without videoId or title is consumed but not added. False if malformed.
+inline bool ReadTrackRecord(RecordReader& reader, TrackTable& tracks) {
+    size_t rowStart = tracks.ArenaSize();
+    TrackTable::Row track = TrackTable::Row();
+    uint32_t* fields[] = { &track.videoId, &track.title, &track.artist, &track.album, &track.thumbnail };
+    const char* data;
+    size_t size;
+    for (uint32_t* field : fields) {
+        if (!reader.ReadString(data, size)) {
+            tracks.TruncateArena(rowStart);
+            return false;
+        }
+        *field = tracks.AddString(data, size);
+    }
+    uint32_t duration;
+    uint8_t flags;
+    if (!reader.ReadU32(duration) || !reader.ReadU8(flags)) {
+        tracks.TruncateArena(rowStart);
+        return false;
+    }
+    track.duration = (float)duration;
+    track.isVideo = (flags & 1) != 0;
+
+    if (track.videoId && track.title) {
+        tracks.AddRow(track);
+    } else {
+        tracks.TruncateArena(rowStart);
+    }
+    return true;
+}
+
+// Append one track as a binary track record
+inline void WriteTrackRecord(std::string& out, const TrackTable& tracks, const TrackTable::Row& track) {
+    uint32_t fields[] = { track.videoId, track.title, track.artist, track.album, track.thumbnail };
+    for (uint32_t field : fields) {
+        const char* text = tracks.Str(field);
+        size_t size = std::min(strlen(text), (size_t)0xFFFF);
+        out += (char)(size & 0xFF);
+        out += (char)(size >> 8);
+        out.append(text, size);
+    }
+    uint32_t duration = track.duration > 0 ? (uint32_t)track.duration : 0;
+    for (int i = 0; i < 4; i++) out += (char)((duration >> (8 * i)) & 0xFF);
+    out += (char)(track.isVideo ? 1 : 0);
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Playlist data structure
+struct Playlist {
+    std::string playlistId;
+    std::string title;
+    int count;
+    std::string thumbnail;
+};
+
+//////////////////////////////////////////////////////////////////////////
+// Extract the stream URL from a /get_url response ("streamUrl", or "url" as fallback)
+inline std::string ExtractStreamUrl(const std::string& response) {
+    std::string streamUrl = SimpleJSON::ExtractString(response, "streamUrl");
+    if (streamUrl.empty()) {
+        streamUrl = SimpleJSON::ExtractString(response, "url");
+    }
+    return streamUrl;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Background worker pool - runs queued tasks off the VDJ calling threads
+class WorkerPool {
+private:
+    std::vector<std::thread> threads;
+    std::deque<std::function<void()>> tasks;
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool stopping;
+
+    void ThreadLoop() {
+        for (;;) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                cv.wait(lock, [this] { return stopping || !tasks.empty(); });
+                if (stopping) return;
+                task = std::move(tasks.front());
+                tasks.pop_front();
+            }
+            task();
+        }
+    }
+
+public:
+    explicit WorkerPool(int threadCount) : stopping(false) {
+        if (threadCount < 1) threadCount = 1;
+        for (int i = 0; i < threadCount; i++) {
+            threads.emplace_back(&WorkerPool::ThreadLoop, this);
+        }
+    }
+
+    ~WorkerPool() {
+        Shutdown();
+    }
+
+    void Submit(std::function<void()> task) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (stopping) return;
+            tasks.push_back(std::move(task));
+        }
+        cv.notify_one();
+    }
+
+    // Drop queued tasks and wait for running ones to finish
+    void Shutdown() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (stopping && threads.empty()) return;
+            stopping = true;
+            tasks.clear();
+        }
+        cv.notify_all();
+        for (auto& t : threads) {
+            if (t.joinable()) t.join();
+        }
+        threads.clear();
+    }
+};
+
+//////////////////////////////////////////////////////////////////////////
+// Resolved stream URL plus the time (unix seconds) after which it stops working
+struct StreamUrlInfo {
+    std::string url;
+    time_t expiresAt;
+};
+
+// Read the expiry embedded in a signed stream URL ("expire=1700000000" query
+// parameter or "/expire/1700000000/" path segment). Returns 0 if there is none.
+inline time_t ExpiryFromUrl(const std::string& url) {
+    size_t pos = url.find("expire=");
+    size_t skip = 7;
+    if (pos == std::string::npos) {
+        pos = url.find("/expire/");
+        skip = 8;
+    }
+    if (pos == std::string::npos) return 0;
+    pos += skip;
+
+    time_t value = 0;
+    while (pos < url.size() && url[pos] >= '0' && url[pos] <= '9') {
+        value = value * 10 + (url[pos++] - '0');
+    }
+    return value;
+}
+
+// Expiry from the bridge's "ttl" (seconds) or "expiresAt" (unix seconds), else
+// from the URL itself, else StreamUrlDefaultTtl from now
+inline void SetStreamUrlExpiry(StreamUrlInfo& info, int ttl, long long expiresAt) {
+    time_t now = time(nullptr);
+    if (ttl > 0) info.expiresAt = now + ttl;
+    else if (expiresAt > 0) info.expiresAt = (time_t)expiresAt;
+    else if (time_t fromUrl = ExpiryFromUrl(info.url)) info.expiresAt = fromUrl;
+    else info.expiresAt = now + StreamUrlDefaultTtl;
+}
+
+// Parse a /get_url response. The bridge may send "ttl" (seconds) or
+// "expiresAt" (unix seconds); otherwise the expiry is read from the URL,
+// falling back to StreamUrlDefaultTtl.
+inline bool ParseStreamUrlResponse(const std::string& response, StreamUrlInfo& info) {
+    MetricTimer timer(Metrics::StageParse);
+    info.url = ExtractStreamUrl(response);
+    if (info.url.empty()) return false;
+    SetStreamUrlExpiry(info, SimpleJSON::ExtractInt(response, "ttl"), SimpleJSON::ExtractInt(response, "expiresAt"));
+    return true;
+}
+
+// Parse a /get_urls response: {"results": [<get_url object>, ...]} or a plain
+// array. Entries without a URL (e.g. {"videoId": ..., "detail": ...}) are skipped.
+inline void ParseStreamUrlBatch(const std::string& response, std::unordered_map<std::string, StreamUrlInfo>& results) {
+    MetricTimer timer(Metrics::StageParse);
+    JsonReader reader(response);
+    if (!reader.SeekArray()) return;
+
+    std::string videoId;
+    StreamUrlInfo info;
+    for (;;) {
+        JsonReader::Token t = reader.Next();
+        if (t != JsonReader::BeginObject) {
+            if (t == JsonReader::EndArray || !reader.Skip(t)) break;
+            continue;
+        }
+
+        videoId.clear();
+        info.url.clear();
+        int ttl = 0;
+        double expiresAt = 0;
+        while ((t = reader.Next()) == JsonReader::Key) {
+            int kind = 0; // 1 = videoId, 2 = streamUrl, 3 = url, 4 = ttl, 5 = expiresAt
+            if (reader.KeyIs("videoId")) kind = 1;
+            else if (reader.KeyIs("streamUrl")) kind = 2;
+            else if (reader.KeyIs("url")) kind = 3;
+            else if (reader.KeyIs("ttl")) kind = 4;
+            else if (reader.KeyIs("expiresAt")) kind = 5;
+
+            JsonReader::Token v = reader.Next();
+            if (kind == 1 && v == JsonReader::String) reader.ReadString(videoId);
+            else if (kind == 2 && v == JsonReader::String) reader.ReadString(info.url);
+            else if (kind == 3 && v == JsonReader::String && info.url.empty()) reader.ReadString(info.url);
+            else if (kind == 4) ttl = reader.AsInt(v);
+            else if (kind == 5) expiresAt = reader.AsNumber(v);
+            if (!reader.Skip(v)) return;
+        }
+        if (t != JsonReader::EndObject) break;
+
+        if (videoId.empty() || info.url.empty()) continue;
+        SetStreamUrlExpiry(info, ttl, (expiresAt > 0 && expiresAt < 1e15) ? (long long)expiresAt : 0);
+        results[videoId] = info;
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////
+// StreamUrlCache - videoId -> stream URL, honoring each URL's expiry.
+// Entries for tracks that are still in use (recently loaded on a deck or
+// part of the open playlist) are re-resolved in the background before they
+// expire. The cache is written to disk so it survives a VirtualDJ restart.
+class StreamUrlCache {
+private:
+    enum {
+        ExpirySafetySeconds = 120,      // entries this close to expiry are treated as expired
+        RefreshAheadSeconds = 600,      // hot entries are re-resolved this long before expiry
+        RefreshIntervalSeconds = 30
+    };
+    static const size_t MaxEntries = 2000;
+    static const size_t MaxRecentIds = 16;
+
+    HttpClient& http;
+    std::string filePath;
+    std::mutex mutex;
+    std::unordered_map<std::string, StreamUrlInfo> entries;
+    std::deque<std::string> recentIds;              // last ids loaded on a deck
+    std::unordered_set<std::string> playlistIds;    // ids in the open playlist
+    bool dirty;
+
+    std::atomic<uint64_t> hits;
+    std::atomic<uint64_t> misses;
+    std::atomic<uint64_t> refreshes;
+
+    std::thread refreshThread;
+    std::mutex stopMutex;
+    std::condition_variable stopCv;
+    bool stopping;
+
+    bool IsHot(const std::string& videoId) const {
+        if (playlistIds.count(videoId)) return true;
+        return std::find(recentIds.begin(), recentIds.end(), videoId) != recentIds.end();
+    }
+
+    void EvictIfNeeded(time_t now) {
+        if (entries.size() <= MaxEntries) return;
+        for (auto it = entries.begin(); it != entries.end();) {
+            if (it->second.expiresAt <= now + ExpirySafetySeconds) it = entries.erase(it);
+            else ++it;
+        }
+        while (entries.size() > MaxEntries) {
+            // Drop the entry that expires first
+            auto oldest = entries.begin();
+            for (auto it = entries.begin(); it != entries.end(); ++it) {
+                if (it->second.expiresAt < oldest->second.expiresAt) oldest = it;
+            }
+            entries.erase(oldest);
+        }
+    }
+
+    void RefreshDueEntries() {
+        std::vector<std::string> due;
+        time_t now = time(nullptr);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (const auto& entry : entries) {
+                if (entry.second.expiresAt - now < RefreshAheadSeconds && IsHot(entry.first)) {
+                    due.push_back(entry.first);
+                }
+            }
+        }
+
+        for (const auto& videoId : due) {
+            {
+                std::lock_guard<std::mutex> lock(stopMutex);
+                if (stopping) return;
+            }
+            HttpRequestOptions options;
+            options.background = true;
+            StreamUrlInfo info;
+            if (ParseStreamUrlResponse(http.Get("/get_url?id=" + videoId, options), info)) {
+                Store(videoId, info);
+                refreshes++;
+                Logger::Log("StreamUrlCache: Refreshed " + videoId);
+            }
+        }
+    }
+
+    void RefreshLoop() {
+        std::unique_lock<std::mutex> lock(stopMutex);
+        while (!stopping) {
+            stopCv.wait_for(lock, std::chrono::seconds(RefreshIntervalSeconds));
+            if (stopping) break;
+            lock.unlock();
+            RefreshDueEntries();
+            Save();
+            lock.lock();
+        }
+    }
+
+public:
+    StreamUrlCache(HttpClient& client, const std::string& path)
+        : http(client), filePath(path), dirty(false), hits(0), misses(0), refreshes(0), stopping(false) {}
+
+    ~StreamUrlCache() {
+        Stop();
+    }
+
+    void Start() {
+        if (!refreshThread.joinable()) {
+            refreshThread = std::thread(&StreamUrlCache::RefreshLoop, this);
+        }
+    }
+
+    void Stop() {
+        {
+            std::lock_guard<std::mutex> lock(stopMutex);
+            stopping = true;
+        }
+        stopCv.notify_all();
+        if (refreshThread.joinable()) refreshThread.join();
+        Save();
+    }
+
+    // Look up a usable URL; counts a hit or a miss
+    bool Lookup(const std::string& videoId, std::string& url) {
+        time_t now = time(nullptr);
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = entries.find(videoId);
+        if (it != entries.end() && it->second.expiresAt > now + ExpirySafetySeconds) {
+            url = it->second.url;
+            hits++;
+            Metrics::Count(Metrics::StreamUrlCacheHits);
+            return true;
+        }
+        misses++;
+        Metrics::Count(Metrics::StreamUrlCacheMisses);
+        return false;
+    }
+
+    // True if a usable URL is cached (copied to *url if given); does not touch the counters
+    bool Contains(const std::string& videoId, std::string* url = nullptr) {
+        time_t now = time(nullptr);
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = entries.find(videoId);
+        if (it == entries.end() || it->second.expiresAt <= now + ExpirySafetySeconds) return false;
+        if (url) *url = it->second.url;
+        return true;
+    }
+
+    void Store(const std::string& videoId, const StreamUrlInfo& info) {
+        std::lock_guard<std::mutex> lock(mutex);
+        entries[videoId] = info;
+        dirty = true;
+        EvictIfNeeded(time(nullptr));
+    }
+
+    // Remember a track that was loaded on a deck
+    void MarkInUse(const std::string& videoId) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = std::find(recentIds.begin(), recentIds.end(), videoId);
+        if (it != recentIds.end()) recentIds.erase(it);
+        recentIds.push_back(videoId);
+        while (recentIds.size() > MaxRecentIds) recentIds.pop_front();
+    }
+
+    // Replace the set of ids in the currently open playlist
+    void SetPlaylistIds(const std::vector<std::string>& videoIds) {
+        std::lock_guard<std::mutex> lock(mutex);
+        playlistIds.clear();
+        playlistIds.insert(videoIds.begin(), videoIds.end());
+    }
+
+    // Load entries persisted by a previous session, skipping expired ones
+    void Load() {
+        std::ifstream file(filePath);
+        if (!file.is_open()) return;
+
+        time_t now = time(nullptr);
+        size_t loaded = 0;
+        std::string line;
+        std::lock_guard<std::mutex> lock(mutex);
+        while (std::getline(file, line)) {
+            // videoId \t expiresAt \t url
+            size_t tab1 = line.find('\t');
+            size_t tab2 = tab1 == std::string::npos ? tab1 : line.find('\t', tab1 + 1);
+            if (tab2 == std::string::npos) continue;
+
+            StreamUrlInfo info;
+            info.expiresAt = (time_t)strtoll(line.c_str() + tab1 + 1, nullptr, 10);
+            info.url = line.substr(tab2 + 1);
+            if (info.expiresAt <= now + ExpirySafetySeconds || info.url.empty()) continue;
+            entries[line.substr(0, tab1)] = info;
+            loaded++;
+        }
+        Logger::Log("StreamUrlCache: Loaded " + std::to_string(loaded) + " entries from " + filePath);
+    }
+
+    // Write the cache to disk if it changed since the last save
+    void Save() {
+        std::string contents;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!dirty) return;
+            dirty = false;
+            time_t now = time(nullptr);
+            for (const auto& entry : entries) {
+                if (entry.second.expiresAt <= now + ExpirySafetySeconds) continue;
+                contents += entry.first + "\t" + std::to_string((long long)entry.second.expiresAt) + "\t" + entry.second.url + "\n";
+            }
+        }
+
+        std::string tempPath = filePath + ".tmp";
+        {
+            std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+            if (!file.is_open()) return;
+            file << contents;
+        }
+        std::remove(filePath.c_str());
+        std::rename(tempPath.c_str(), filePath.c_str());
+    }
+
+    uint64_t Hits() const { return hits; }
+    uint64_t Misses() const { return misses; }
+    uint64_t Refreshes() const { return refreshes; }
+
+    std::string StatsString() const {
+        return "hits=" + std::to_string(Hits()) + " misses=" + std::to_string(Misses()) +
+            " refreshes=" + std::to_string(Refreshes());
+    }
+};
+
+//////////////////////////////////////////////////////////////////////////
+// StreamUrlBatcher - resolves stream URLs through /get_urls?ids=a,b,c so the
+// tracks of an opened playlist cost one bridge round-trip per batch instead
+// of one /get_url each. Ids queued within UrlBatchWindowMs go out together
+// (at most UrlBatchMaxIds per request) and the results are stored in the
+// StreamUrlCache. Batches go out at background priority; a track loaded
+// while its id is still queued is taken out of the batch and resolved by
+// the caller, and one already in flight is waited for at most
+// UrlBatchWaitMs. Bridges without /get_urls are detected on the first 404 and served with
+// per-id /get_url requests from then on.
+class StreamUrlBatcher {
+private:
+    struct Pending {
+        bool sent;
+        bool done;
+        bool resolved;
+        int waiters;
+        StreamUrlInfo info;
+
+        Pending() : sent(false), done(false), resolved(false), waiters(0) {}
+    };
+    typedef std::shared_ptr<Pending> PendingPtr;
+
+    HttpClient& http;
+    StreamUrlCache& cache;
+    std::mutex mutex;
+    std::condition_variable queueCv;    // wakes the batch thread
+    std::condition_variable doneCv;     // wakes waiters when a batch completes
+    std::deque<std::string> queue;      // ids not sent yet
+    std::unordered_map<std::string, PendingPtr> pending;   // queued or in flight
+    bool stopping;
+    std::atomic<bool> batchSupported;
+    CancelTokenPtr cancel;
+    std::thread thread;
+
+    std::atomic<uint64_t> batches;
+    std::atomic<uint64_t> resolvedIds;
+
+    enum { PerIdTimeoutMs = 5000 };     // the bridge takes 3-5 s per id
+
+    // Resolve ids with one /get_urls request; false if the bridge does not have it
+    bool FetchBatch(const std::vector<std::string>& ids, bool background,
+                    std::unordered_map<std::string, StreamUrlInfo>& results) {
+        std::string endpoint = "/get_urls?ids=";
+        for (size_t i = 0; i < ids.size(); i++) {
+            if (i) endpoint += ',';
+            endpoint += ids[i];
+        }
+
+        HttpRequestOptions options;
+        options.background = background;
+        options.cancel = cancel;
+        options.timeoutMs += (long)ids.size() * PerIdTimeoutMs;
+        HttpResponse response = http.Request(endpoint, options);
+        if (response.status == 404 || response.status == 405) {
+            batchSupported = false;
+            Logger::Log("StreamUrlBatcher: Bridge has no /get_urls, resolving ids one by one");
+            return false;
+        }
+        ParseStreamUrlBatch(response.body, results);
+        batches++;
+        return true;
+    }
+
+    void FetchEach(const std::vector<std::string>& ids, bool background,
+                   std::unordered_map<std::string, StreamUrlInfo>& results) {
+        for (const auto& id : ids) {
+            if (cancel->IsCancelled()) return;
+            HttpRequestOptions options;
+            options.background = background;
+            options.cancel = cancel;
+            StreamUrlInfo info;
+            if (ParseStreamUrlResponse(http.Get("/get_url?id=" + id, options), info)) {
+                results[id] = info;
+            }
+        }
+    }
+
+    void BatchLoop() {
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;) {
+            queueCv.wait(lock, [this] { return stopping || !queue.empty(); });
+            if (stopping) break;
+
+            // Give the caller a moment to queue more ids
+            size_t maxIds = UrlBatchMaxIds > 0 ? (size_t)UrlBatchMaxIds : 1;
+            queueCv.wait_for(lock, std::chrono::milliseconds(UrlBatchWindowMs), [&] {
+                return stopping || queue.size() >= maxIds;
+            });
+            if (stopping) break;
+            if (queue.empty()) continue;        // every queued id was taken by Wait
+
+            std::vector<std::string> ids;
+            while (!queue.empty() && ids.size() < maxIds) {
+                ids.push_back(std::move(queue.front()));
+                queue.pop_front();
+                pending[ids.back()]->sent = true;
+            }
+            lock.unlock();
+
+            std::unordered_map<std::string, StreamUrlInfo> results;
+            if (!batchSupported || !FetchBatch(ids, true, results)) {
+                FetchEach(ids, true, results);
+            }
+            for (const auto& result : results) cache.Store(result.first, result.second);
+            resolvedIds += results.size();
+            Logger::Log("StreamUrlBatcher: Resolved " + std::to_string(results.size()) + " of " +
+                std::to_string(ids.size()) + " stream URLs");
+
+            lock.lock();
+            for (const auto& id : ids) {
+                auto it = pending.find(id);
+                if (it == pending.end()) continue;
+                auto found = results.find(id);
+                if (found != results.end()) {
+                    it->second->info = found->second;
+                    it->second->resolved = true;
+                }
+                it->second->done = true;
+                pending.erase(it);
+            }
+            doneCv.notify_all();
+        }
+
+        // Release anyone still waiting
+        for (auto& entry : pending) entry.second->done = true;
+        pending.clear();
+        queue.clear();
+        doneCv.notify_all();
+    }
+
+public:
+    StreamUrlBatcher(HttpClient& client, StreamUrlCache& urlCache)
+        : http(client), cache(urlCache), stopping(false), batchSupported(true),
+          cancel(std::make_shared<CancelToken>()), batches(0), resolvedIds(0) {}
+
+    ~StreamUrlBatcher() {
+        Stop();
+    }
+
+    void Start() {
+        if (!thread.joinable()) thread = std::thread(&StreamUrlBatcher::BatchLoop, this);
+    }
+
+    void Stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        cancel->Cancel();
+        queueCv.notify_all();
+        if (thread.joinable()) thread.join();
+    }
+
+    // Queue ids for background resolution, replacing queued ids of an earlier
+    // call that nobody is waiting for. Cached and pending ids are skipped.
+    void Enqueue(const std::vector<std::string>& videoIds) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stopping) return;
+        for (auto it = queue.begin(); it != queue.end();) {
+            auto entry = pending.find(*it);
+            if (entry->second->waiters == 0) {
+                pending.erase(entry);
+                it = queue.erase(it);
+            } else {
+                ++it;
+            }
+        }
+
+        size_t queued = 0;
+        for (const auto& id : videoIds) {
+            if (pending.count(id) || cache.Contains(id)) continue;
+            pending[id] = std::make_shared<Pending>();
+            queue.push_back(id);
+            queued++;
+        }
+        if (queued) queueCv.notify_one();
+    }
+
+    // For a track being loaded: an id still queued is taken out of its batch
+    // (false, the caller resolves it itself) and one in flight is waited for
+    // at most UrlBatchWaitMs. Also false if the id is not pending or its
+    // batch could not resolve it.
+    bool Wait(const std::string& videoId, StreamUrlInfo& info) {
+        std::unique_lock<std::mutex> lock(mutex);
+        auto it = pending.find(videoId);
+        if (it == pending.end()) return false;
+
+        PendingPtr entry = it->second;
+        if (!entry->sent) {
+            queue.erase(std::find(queue.begin(), queue.end(), videoId));
+            pending.erase(it);
+            entry->done = true;
+            doneCv.notify_all();
+            return false;
+        }
+        entry->waiters++;
+        doneCv.wait_for(lock, std::chrono::milliseconds(UrlBatchWaitMs), [&] { return entry->done; });
+        entry->waiters--;
+        if (!entry->resolved) return false;
+        info = entry->info;
+        return true;
+    }
+
+    // For prefetching: wait for a pending id without taking it out of its
+    // batch or changing the batch's priority. Gives up once abandoned()
+    // returns true (checked every 50 ms). False if the id is not pending,
+    // was given up on, or its batch could not resolve it.
+    bool WaitQueued(const std::string& videoId, StreamUrlInfo& info, const std::function<bool()>& abandoned) {
+        std::unique_lock<std::mutex> lock(mutex);
+        auto it = pending.find(videoId);
+        if (it == pending.end()) return false;
+
+        PendingPtr entry = it->second;
+        entry->waiters++;
+        while (!entry->done && !abandoned()) {
+            doneCv.wait_for(lock, std::chrono::milliseconds(50));
+        }
+        entry->waiters--;
+        if (!entry->resolved) return false;
+        info = entry->info;
+        return true;
+    }
+
+    std::string StatsString() const {
+        return "batches=" + std::to_string(batches.load()) + " resolved=" + std::to_string(resolvedIds.load());
+    }
+};
+
+//////////////////////////////////////////////////////////////////////////
+// MappedFile - read/write memory mapping of a whole file
+class MappedFile {
+private:
+#ifdef VDJ_WIN
+    HANDLE file;
+    HANDLE mapping;
+#else
+    int fd;
+#endif
+    char* data;
+    size_t size;
+
+public:
+#ifdef VDJ_WIN
+    MappedFile() : file(INVALID_HANDLE_VALUE), mapping(NULL), data(nullptr), size(0) {}
+#else
+    MappedFile() : fd(-1), data(nullptr), size(0) {}
+#endif
+
+    ~MappedFile() {
+        Close();
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Open (creating if needed) and map the file, growing it with zeroes to
+    // at least minSize bytes
+    bool Open(const std::string& path, size_t minSize) {
+        Close();
+#ifdef VDJ_WIN
+        file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL,
+            OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (file == INVALID_HANDLE_VALUE) return false;
+
+        LARGE_INTEGER existing;
+        if (!GetFileSizeEx(file, &existing)) {
+            Close();
+            return false;
+        }
+        size = std::max((size_t)existing.QuadPart, minSize);
+        // Mapping beyond the end of the file extends it
+        mapping = CreateFileMappingA(file, NULL, PAGE_READWRITE,
+            (DWORD)((uint64_t)size >> 32), (DWORD)(size & 0xFFFFFFFF), NULL);
+        if (mapping) data = (char*)MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+#else
+        fd = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+        if (fd < 0) return false;
+
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            Close();
+            return false;
+        }
+        size = std::max((size_t)st.st_size, minSize);
+        if ((size_t)st.st_size < size && ftruncate(fd, (off_t)size) != 0) {
+            Close();
+            return false;
+        }
+        void* view = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (view != MAP_FAILED) data = (char*)view;
+#endif
+        if (!data) {
+            Close();
+            return false;
+        }
+        return true;
+    }
+
+    // Schedule dirty pages for writing without waiting for the disk
+    void Flush() {
+        if (!data) return;
+#ifdef VDJ_WIN
+        FlushViewOfFile(data, 0);
+#else
+        msync(data, size, MS_ASYNC);
+#endif
+    }
+
+    void Close() {
+#ifdef VDJ_WIN
+        if (data) UnmapViewOfFile(data);
+        if (mapping) CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+        mapping = NULL;
+        file = INVALID_HANDLE_VALUE;
+#else
+        if (data) munmap(data, size);
+        if (fd >= 0) close(fd);
+        fd = -1;
+#endif
+        data = nullptr;
+        size = 0;
+    }
+
+    bool IsOpen() const { return data != nullptr; }
+    char* Data() const { return data; }
+    size_t Size() const { return size; }
+};
+
+// Create a directory if it does not exist yet
+inline bool EnsureDirectory(const std::string& path) {
+#ifdef VDJ_WIN
+    return CreateDirectoryA(path.c_str(), NULL) || GetLastError() == ERROR_ALREADY_EXISTS;
+#else
+    return mkdir(path.c_str(), 0755) == 0 || errno == EEXIST;
+#endif
+}
+
+inline bool FileExists(const std::string& path) {
+#ifdef VDJ_WIN
+    DWORD attributes = GetFileAttributesA(path.c_str());
+    return attributes != INVALID_FILE_ATTRIBUTES && !(attributes & FILE_ATTRIBUTE_DIRECTORY);
+#else
+    struct stat st;
+    return stat(path.c_str(), &st) == 0 && S_ISREG(st.st_mode);
+#endif
+}
+
+// Move a stdio file position to a 64-bit offset
+inline bool SeekFile(FILE* file, long long offset) {
+#ifdef VDJ_WIN
+    return _fseeki64(file, offset, SEEK_SET) == 0;
+#else
+    return fseeko(file, (off_t)offset, SEEK_SET) == 0;
+#endif
+}
+
+// file:// URI for a local absolute path ("C:\x\a b.m4a" -> "file:///C:/x/a%20b.m4a")
+inline std::string PathToFileUri(const std::string& path) {
+    static const char hex[] = "0123456789ABCDEF";
+    std::string uri = path.empty() || path[0] != '/' ? "file:///" : "file://";
+    for (char c : path) {
+        unsigned char u = (unsigned char)c;
+        if (c == '\\') uri += '/';
+        else if (isalnum(u) || strchr("/:-_.~", c)) uri += c;
+        else {
+            uri += '%';
+            uri += hex[u >> 4];
+            uri += hex[u & 15];
+        }
+    }
+    return uri;
+}
+
+// File extension for a stream URL, from its mime= parameter ("audio%2Fwebm")
+inline std::string GuessAudioExtension(const std::string& url) {
+    size_t pos = url.find("mime=");
+    if (pos != std::string::npos) {
+        std::string mime = url.substr(pos + 5, url.find('&', pos) - pos - 5);
+        if (mime.find("webm") != std::string::npos) return "webm";
+        if (mime.find("mpeg") != std::string::npos) return "mp3";
+        if (mime.find("ogg") != std::string::npos) return "ogg";
+    }
+    return "m4a";
+}
+
+//////////////////////////////////////////////////////////////////////////
+// PartialTrack - a track file being filled by ranged downloads while it is
+// read. The file is split into fixed-size chunks; a reader waiting for a
+// chunk that is not there yet asks for it to be fetched next, so a seek is
+// served before the linear fill gets there.
+struct PartialTrack {
+    enum { ChunkSize = 256 * 1024 };
+
+    std::string videoId;
+    std::string url;
+    std::string ext;
+    std::string path;           // .part file while filling, final file once cached
+    CancelTokenPtr cancel;
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    long long totalSize;        // -1 until known
+    std::vector<bool> chunks;   // filled chunks
+    long long wantedOffset;     // offset a reader is waiting for, -1 if none
+    bool complete;
+    bool failed;
+    std::atomic<bool> paced;    // predicted download held to PrefetchBandwidthKBps until loaded
+
+    PartialTrack() : cancel(std::make_shared<CancelToken>()), totalSize(-1), wantedOffset(-1),
+        complete(false), failed(false), paced(false) {}
+
+    // Bytes readable from offset without waiting. Caller holds mutex.
+    long long AvailableAt(long long offset) const {
+        if (complete) return totalSize - offset;
+        size_t first = (size_t)(offset / ChunkSize);
+        size_t end = first;
+        while (end < chunks.size() && chunks[end]) end++;
+        if (end == first) return 0;
+        long long limit = (long long)end * ChunkSize;
+        if (totalSize >= 0) limit = std::min(limit, totalSize);
+        return limit - offset;
+    }
+
+    // Wait until the size of the track is known. Returns it, or -1 on
+    // failure or timeout.
+    long long WaitForSize(int timeoutMs) {
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait_for(lock, std::chrono::milliseconds(timeoutMs), [this] {
+            return totalSize >= 0 || complete || failed;
+        });
+        return totalSize;
+    }
+
+    // Wait until data at offset is on disk, asking the filler to fetch it
+    // next. Returns the bytes readable from offset, 0 at the end of the
+    // track, -1 on failure or timeout.
+    long long WaitAvailable(long long offset, int timeoutMs) {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            if (totalSize >= 0 && offset >= totalSize) return 0;
+            long long available = AvailableAt(offset);
+            if (available > 0) return available;
+            if (failed) return -1;
+            wantedOffset = offset;
+            if (changed.wait_until(lock, deadline) == std::cv_status::timeout && AvailableAt(offset) <= 0) {
+                return -1;
+            }
+        }
+    }
+};
+
+typedef std::shared_ptr<PartialTrack> PartialTrackPtr;
+
+//////////////////////////////////////////////////////////////////////////
+// Smaller variant of a cover URL, so the image host does the downscaling:
+// i.ytimg.com thumbnails pick the named size closest to ThumbnailSize and
+// googleusercontent album art ("...=w544-h544-l90-rj") gets new dimensions.
+// Other URLs are returned unchanged.
+inline std::string SmallThumbnailUrl(const std::string& url) {
+    if (url.find("i.ytimg.com/") != std::string::npos) {
+        size_t slash = url.rfind('/');
+        size_t query = url.find('?', slash);
+        std::string name = url.substr(slash + 1, query == std::string::npos ? std::string::npos : query - slash - 1);
+        if (name == "hqdefault.jpg" || name == "sddefault.jpg" || name == "maxresdefault.jpg" || name == "mqdefault.jpg") {
+            const char* smaller = ThumbnailSize <= 120 ? "default.jpg" : ThumbnailSize <= 320 ? "mqdefault.jpg" : "hqdefault.jpg";
+            return url.substr(0, slash + 1) + smaller;
+        }
+        return url;
+    }
+    if (url.find("googleusercontent.com/") != std::string::npos) {
+        size_t equals = url.rfind('=');
+        if (equals != std::string::npos && equals + 1 < url.size() && url[equals + 1] == 'w' &&
+            url.find("-h", equals) != std::string::npos) {
+            std::string size = std::to_string(ThumbnailSize);
+            return url.substr(0, equals) + "=w" + size + "-h" + size + "-l90-rj";
+        }
+    }
+    return url;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// ThumbnailCache - covers of listed tracks on disk, so the browser shows
+// them from file:// URIs instead of loading every image from the internet.
+// After a search or playlist load the missing covers are fetched in the
+// background, at most ThumbnailFetchThreads at a time, in their small
+// variant (SmallThumbnailUrl). Files are named by a hash of their
+// contents, so album art shared by many tracks is stored once; an index
+// (url hash -> content hash) is kept in index.txt. The oldest covers are
+// dropped beyond ThumbnailCacheMaxBytes.
+class ThumbnailCache {
+private:
+    enum { MaxImageBytes = 2 * 1024 * 1024 };
+
+    struct Blob {
+        long long size;
+        int refs;
+    };
+
+    HttpClient& http;
+    std::string directory;
+    std::mutex mutex;
+    std::unordered_map<uint64_t, uint64_t> byUrl;       // url hash -> content hash
+    std::deque<uint64_t> order;                         // url hashes, oldest first
+    std::unordered_map<uint64_t, Blob> blobs;           // content hash -> file
+    std::unordered_set<uint64_t> pending;               // url hashes queued or downloading
+    long long totalBytes;
+    bool dirty;
+    bool started;
+    std::atomic<unsigned> generation;
+    CancelTokenPtr cancel;
+    std::unique_ptr<WorkerPool> pool;
+
+    std::atomic<uint64_t> hits;
+    std::atomic<uint64_t> fetched;
+
+    static uint64_t HashUrl(const std::string& url) {
+        return HashBytes(url.data(), url.size());
+    }
+
+    static std::string Hex(uint64_t value) {
+        char buf[17];
+        snprintf(buf, sizeof(buf), "%016llx", (unsigned long long)value);
+        return buf;
+    }
+
+    std::string BlobPath(uint64_t contentHash) const {
+        return directory + "/" + Hex(contentHash) + ".jpg";
+    }
+
+    // Map a url to a stored blob; mutex must be held
+    void Link(uint64_t urlHash, uint64_t contentHash, long long size) {
+        Blob& blob = blobs[contentHash];
+        if (blob.refs == 0) {
+            blob.size = size;
+            totalBytes += size;
+        }
+        blob.refs++;
+        byUrl[urlHash] = contentHash;
+        order.push_back(urlHash);
+        dirty = true;
+    }
+
+    // Drop the oldest urls until under budget; mutex must be held
+    void Trim() {
+        while (totalBytes > ThumbnailCacheMaxBytes && !order.empty()) {
+            uint64_t urlHash = order.front();
+            order.pop_front();
+            auto it = byUrl.find(urlHash);
+            if (it == byUrl.end()) continue;
+            auto blob = blobs.find(it->second);
+            if (blob != blobs.end() && --blob->second.refs == 0) {
+                totalBytes -= blob->second.size;
+                std::remove(BlobPath(blob->first).c_str());
+                blobs.erase(blob);
+            }
+            byUrl.erase(it);
+            dirty = true;
+        }
+    }
+
+    void Fetch(const std::string& url, uint64_t urlHash, unsigned gen) {
+        std::string image;
+        bool ok = false;
+        if (generation == gen) {
+            HttpRequestOptions options(15000);
+            options.background = true;
+            options.cancel = cancel;
+            ok = http.DownloadUrl(SmallThumbnailUrl(url), options, [&image](const char* data, size_t size) {
+                if (image.size() + size > MaxImageBytes) return false;
+                image.append(data, size);
+                return true;
+            });
+        }
+
+        uint64_t contentHash = ok && !image.empty() ? HashBytes(image.data(), image.size()) : 0;
+        bool write = false;
+        if (contentHash) {
+            std::lock_guard<std::mutex> lock(mutex);
+            write = !blobs.count(contentHash);
+        }
+        if (write) {
+            std::string path = BlobPath(contentHash);
+            std::string tempPath = path + ".part";
+            {
+                std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+                if (file.is_open()) file.write(image.data(), (std::streamsize)image.size());
+                write = file.good();
+            }
+            std::remove(path.c_str());
+            if (!write || std::rename(tempPath.c_str(), path.c_str()) != 0) {
+                std::remove(tempPath.c_str());
+                contentHash = 0;
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        pending.erase(urlHash);
+        if (!contentHash || byUrl.count(urlHash)) return;
+        Link(urlHash, contentHash, (long long)image.size());
+        Trim();
+        fetched++;
+    }
+
+    void Load() {
+        std::ifstream file(directory + "/index.txt");
+        if (!file.is_open()) return;
+        std::string line;
+        while (std::getline(file, line)) {
+            // urlHash contentHash size (hex, hex, decimal)
+            char* end;
+            uint64_t urlHash = strtoull(line.c_str(), &end, 16);
+            uint64_t contentHash = strtoull(end, &end, 16);
+            long long size = strtoll(end, nullptr, 10);
+            if (!urlHash || !contentHash || size <= 0) continue;
+            if (!blobs.count(contentHash) && !FileExists(BlobPath(contentHash))) continue;
+            if (byUrl.count(urlHash)) continue;
+            Link(urlHash, contentHash, size);
+        }
+        dirty = false;
+        Trim();
+        Logger::Log("ThumbnailCache: Loaded " + std::to_string(byUrl.size()) + " covers (" +
+            std::to_string(blobs.size()) + " files)");
+    }
+
+    void Save() {
+        std::string contents;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!dirty) return;
+            dirty = false;
+            for (uint64_t urlHash : order) {
+                auto it = byUrl.find(urlHash);
+                if (it == byUrl.end()) continue;
+                contents += Hex(urlHash) + " " + Hex(it->second) + " " + std::to_string(blobs[it->second].size) + "\n";
+            }
+        }
+        std::string path = directory + "/index.txt";
+        std::string tempPath = path + ".tmp";
+        {
+            std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+            if (!file.is_open()) return;
+            file << contents;
+        }
+        std::remove(path.c_str());
+        std::rename(tempPath.c_str(), path.c_str());
+    }
+
+public:
+    ThumbnailCache(HttpClient& client, const std::string& dir)
+        : http(client), directory(dir), totalBytes(0), dirty(false), started(false), generation(0),
+          cancel(std::make_shared<CancelToken>()), hits(0), fetched(0) {}
+
+    ~ThumbnailCache() {
+        Stop();
+    }
+
+    void Start() {
+        if (started || !EnsureDirectory(directory)) return;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            Load();
+        }
+        pool.reset(new WorkerPool(ThumbnailFetchThreads));
+        started = true;
+    }
+
+    void Stop() {
+        if (!started) return;
+        started = false;
+        cancel->Cancel();
+        pool->Shutdown();
+        Save();
+    }
+
+    // Local file URI for a cached cover, otherwise the small remote variant
+    std::string CoverFor(const char* url) {
+        if (!*url) return std::string();
+        std::string remote(url);
+        if (started) {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = byUrl.find(HashUrl(remote));
+            if (it != byUrl.end()) {
+                hits++;
+                return PathToFileUri(BlobPath(it->second));
+            }
+        }
+        return SmallThumbnailUrl(remote);
+    }
+
+    // Fetch the missing covers of a list in the background, dropping the
+    // queued ones of the previous list
+    void Prefetch(const TrackTable& tracks) {
+        if (!started) return;
+        unsigned gen = ++generation;
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const auto& track : tracks) {
+            std::string url = tracks.Str(track.thumbnail);
+            if (url.empty()) continue;
+            uint64_t urlHash = HashUrl(url);
+            if (byUrl.count(urlHash) || !pending.insert(urlHash).second) continue;
+            pool->Submit([this, url, urlHash, gen] { Fetch(url, urlHash, gen); });
+        }
+    }
+
+    std::string StatsString() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return "covers=" + std::to_string(byUrl.size()) + " files=" + std::to_string(blobs.size()) +
+            " bytes=" + std::to_string(totalBytes) + " hits=" + std::to_string(hits.load()) +
+            " fetched=" + std::to_string(fetched.load());
+    }
+};
+
+//////////////////////////////////////////////////////////////////////////
+// AudioCache - size-bounded LRU of downloaded tracks on disk, so a cached
+// track loads from a local file instead of the network. Background
+// downloads run one at a time; played tracks go ahead of predicted ones,
+// which are paced to PrefetchBandwidthKBps until they are loaded.
+// Stream() starts filling a track at once on its own thread so it can be
+// played while it downloads (see LoopbackProxy). The index is a fixed-size
+// memory-mapped file (one record per slot) so startup reads it directly
+// instead of scanning the cache directory, and access times written by
+// lookups persist without an explicit save.
+class AudioCache {
+private:
+    enum {
+        IndexVersion = 1,
+        MaxQueuedDownloads = 32,
+        MaxSpanChunks = 8,          // chunks fetched per range request
+        MaxFillRetries = 3,
+        ConnectTimeoutMs = 5000
+    };
+
+    struct IndexHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t capacity;      // number of records following the header
+        uint64_t reserved[2];
+    };
+
+    struct IndexRecord {
+        char videoId[24];       // empty = free slot
+        char ext[8];
+        uint64_t size;
+        uint64_t lastUse;       // LRU sequence number, higher = used more recently
+    };
+
+    struct Download {
+        std::string videoId;
+        std::string url;
+        bool predicted;
+    };
+
+    struct StreamFill {
+        std::thread thread;
+        std::atomic<bool> done;
+        StreamFill() : done(false) {}
+    };
+
+    HttpClient& http;
+    std::string directory;
+    MappedFile index;
+    std::mutex mutex;
+    std::unordered_map<std::string, uint32_t> slots;   // videoId -> record
+    std::vector<uint32_t> freeSlots;
+    uint64_t totalBytes;
+    uint64_t useCounter;    // last lastUse handed out
+    std::unordered_map<std::string, PartialTrackPtr> partials;     // tracks being filled
+    std::list<StreamFill> streamFills;
+
+    std::deque<Download> queue;
+    std::unordered_set<std::string> queued;
+    std::thread downloadThread;
+    std::condition_variable queueCv;
+    bool stopping;
+
+    std::atomic<uint64_t> hits;
+    std::atomic<uint64_t> misses;
+    std::atomic<uint64_t> downloads;
+    std::atomic<uint64_t> evictions;
+
+    static bool IsSafeName(const std::string& name, size_t maxLength) {
+        if (name.empty() || name.size() >= maxLength) return false;
+        for (char c : name) {
+            if (!isalnum((unsigned char)c) && c != '-' && c != '_') return false;
+        }
+        return true;
+    }
+
+    IndexHeader* Header() const { return (IndexHeader*)index.Data(); }
+    IndexRecord* Records() const { return (IndexRecord*)(index.Data() + sizeof(IndexHeader)); }
+
+    std::string FilePath(const std::string& videoId, const std::string& ext) const {
+#ifdef VDJ_WIN
+        return directory + "\\" + videoId + "." + ext;
+#else
+        return directory + "/" + videoId + "." + ext;
+#endif
+    }
+
+    std::string RecordPath(const IndexRecord& record) const {
+        return FilePath(record.videoId, record.ext);
+    }
+
+    void ReleaseSlot(uint32_t slot) {
+        IndexRecord& record = Records()[slot];
+        slots.erase(record.videoId);
+        totalBytes -= record.size;
+        memset(&record, 0, sizeof(record));
+        freeSlots.push_back(slot);
+    }
+
+    // Evict least recently used files until `incoming` more bytes and one
+    // more record fit. Files that cannot be deleted (open elsewhere) are
+    // skipped. Caller holds mutex.
+    void MakeRoom(uint64_t incoming) {
+        std::vector<std::pair<uint64_t, uint32_t>> byAge;
+        for (const auto& entry : slots) {
+            byAge.push_back(std::make_pair(Records()[entry.second].lastUse, entry.second));
+        }
+        std::sort(byAge.begin(), byAge.end());
+
+        for (const auto& candidate : byAge) {
+            if (totalBytes + incoming <= (uint64_t)AudioCacheMaxBytes && !freeSlots.empty()) break;
+            std::string path = RecordPath(Records()[candidate.second]);
+            if (std::remove(path.c_str()) != 0 && FileExists(path)) continue;
+            ReleaseSlot(candidate.second);
+            evictions++;
+        }
+    }
+
+    // Add a completed download to the index. Caller holds mutex.
+    bool Insert(const std::string& videoId, const std::string& ext, uint64_t size) {
+        if (!index.IsOpen()) return false;
+        MakeRoom(size);
+        if (freeSlots.empty() || totalBytes + size > (uint64_t)AudioCacheMaxBytes) return false;
+
+        uint32_t slot = freeSlots.back();
+        freeSlots.pop_back();
+        IndexRecord& record = Records()[slot];
+        memset(&record, 0, sizeof(record));
+        memcpy(record.videoId, videoId.data(), videoId.size());
+        memcpy(record.ext, ext.data(), ext.size());
+        record.size = size;
+        record.lastUse = ++useCounter;
+        slots[videoId] = slot;
+        totalBytes += size;
+        index.Flush();
+        return true;
+    }
+
+    // Mark the chunks covered by [from, to) as filled and wake readers.
+    // from is chunk aligned; a trailing partial chunk counts once it ends
+    // the track. Returns true if a reader is waiting for a chunk other than
+    // the one being written next, i.e. the current request should yield.
+    static bool MarkFilled(PartialTrack& track, long long from, long long to) {
+        std::lock_guard<std::mutex> lock(track.mutex);
+        size_t first = (size_t)(from / PartialTrack::ChunkSize);
+        size_t end = (size_t)(to / PartialTrack::ChunkSize);
+        if (track.totalSize >= 0 && to >= track.totalSize) end = track.chunks.size();
+        if (track.chunks.size() < end) track.chunks.resize(end, false);
+        for (size_t chunk = first; chunk < end; chunk++) track.chunks[chunk] = true;
+        track.changed.notify_all();
+
+        if (track.wantedOffset < 0) return false;
+        size_t wanted = (size_t)(track.wantedOffset / PartialTrack::ChunkSize);
+        return wanted != end && !(wanted < track.chunks.size() && track.chunks[wanted]);
+    }
+
+    // Pick the next byte range to fetch: the chunk a reader waits for, else
+    // the first missing chunk from `cursor` on (wrapping around). Returns
+    // false when every chunk is filled.
+    static bool PlanSpan(PartialTrack& track, size_t& cursor, long long& first, long long& last) {
+        std::lock_guard<std::mutex> lock(track.mutex);
+        long long spanBytes = (long long)MaxSpanChunks * PartialTrack::ChunkSize;
+        if (track.totalSize < 0) {
+            // Size unknown (no Content-Range yet): continue sequentially
+            first = (long long)track.chunks.size() * PartialTrack::ChunkSize;
+            last = first + spanBytes - 1;
+            return true;
+        }
+
+        size_t count = track.chunks.size();
+        size_t start = count;
+        if (track.wantedOffset >= 0) {
+            size_t wanted = (size_t)(track.wantedOffset / PartialTrack::ChunkSize);
+            if (wanted < count && !track.chunks[wanted]) {
+                // A seek: keep filling linearly from there afterwards
+                start = wanted;
+            } else {
+                track.wantedOffset = -1;
+            }
+        }
+        for (size_t i = 0; start == count && i < count; i++) {
+            size_t chunk = (cursor + i) % count;
+            if (!track.chunks[chunk]) start = chunk;
+        }
+        if (start == count) return false;
+
+        size_t end = start;
+        while (end < count && !track.chunks[end] && end - start < MaxSpanChunks) end++;
+        cursor = end;
+        first = (long long)start * PartialTrack::ChunkSize;
+        last = std::min((long long)end * PartialTrack::ChunkSize, track.totalSize) - 1;
+        return true;
+    }
+
+    // Sleep until `bytes` received since start fit PrefetchBandwidthKBps,
+    // or the track stops being paced
+    static void Pace(PartialTrack& track, std::chrono::steady_clock::time_point start, long long bytes) {
+        while (track.paced && PrefetchBandwidthKBps > 0 && !track.cancel->IsCancelled()) {
+            long long dueMs = bytes * 1000 / (PrefetchBandwidthKBps * 1024LL);
+            long long elapsedMs = (long long)std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - start).count();
+            if (elapsedMs >= dueMs) return;
+            std::this_thread::sleep_for(std::chrono::milliseconds(std::min(dueMs - elapsedMs, 50LL)));
+        }
+    }
+
+    // Download the whole track into track.path with range requests,
+    // fetching what readers wait for first. Returns true when complete.
+    bool Fill(PartialTrack& track) {
+        FILE* file = fopen(track.path.c_str(), "wb");
+        if (!file) {
+            Logger::Error("AudioCache: Cannot create " + track.path);
+            return false;
+        }
+
+        // A single track may take at most a quarter of the budget
+        long long maxFileBytes = AudioCacheMaxBytes / 4;
+        size_t cursor = 0;
+        int failures = 0;
+        bool complete = false;
+        auto paceStart = std::chrono::steady_clock::now();
+        long long pacedBytes = 0;
+        while (!complete && !track.cancel->IsCancelled() && failures < MaxFillRetries) {
+            long long first, last;
+            if (!PlanSpan(track, cursor, first, last)) {
+                complete = true;
+                break;
+            }
+
+            HttpRequestOptions options(0);
+            options.connectTimeoutMs = ConnectTimeoutMs;
+            options.cancel = track.cancel;
+            options.range = std::to_string(first) + "-" + std::to_string(last);
+
+            HttpResponse head;
+            long long origin = first;       // where this response's body starts in the file
+            long long position = first;
+            long long flushedTo = first;
+            bool started = false;
+            bool yielded = false;
+            bool aborted = false;
+            bool ok = http.DownloadUrl(track.url, options, [&](const char* data, size_t size) {
+                if (!started) {
+                    started = true;
+                    // 200 means the range was ignored and the whole file follows
+                    if (head.status == 200) origin = position = flushedTo = 0;
+                    long long total = head.ResourceLength();
+                    std::lock_guard<std::mutex> lock(track.mutex);
+                    if (track.totalSize < 0 && total >= 0) {
+                        track.totalSize = total;
+                        track.chunks.resize((size_t)((total + PartialTrack::ChunkSize - 1) / PartialTrack::ChunkSize), false);
+                        track.changed.notify_all();
+                    }
+                    if (total > maxFileBytes || !SeekFile(file, position)) {
+                        aborted = true;
+                        return false;
+                    }
+                }
+                if (position + (long long)size > maxFileBytes || fwrite(data, 1, size, file) != size) {
+                    aborted = true;
+                    return false;
+                }
+                position += size;
+                pacedBytes += size;
+
+                // Publish whenever a chunk boundary (or the end) is crossed
+                long long boundary = position - position % PartialTrack::ChunkSize;
+                if (boundary > flushedTo || position == track.totalSize) {
+                    fflush(file);
+                    flushedTo = position;
+                    if (MarkFilled(track, origin, position) && head.status == 206) {
+                        yielded = true;
+                        return false;
+                    }
+                }
+                Pace(track, paceStart, pacedBytes);
+                return true;
+            }, &head);
+
+            if (yielded) continue;
+            if (!ok) {
+                if (aborted || track.cancel->IsCancelled() || head.status >= 400) break;
+                failures++;
+                Metrics::Count(Metrics::Retries);
+                std::this_thread::sleep_for(std::chrono::milliseconds(500 * failures));
+                continue;
+            }
+            failures = 0;
+
+            fflush(file);
+            if (head.status == 200 || (head.ResourceLength() < 0 && position <= last)) {
+                // The whole file arrived in one response, or a range came up
+                // short with no size known: either way this is the end
+                std::lock_guard<std::mutex> lock(track.mutex);
+                track.totalSize = position;
+                complete = true;
+            } else {
+                MarkFilled(track, origin, position);
+            }
+        }
+        fclose(file);
+
+        std::lock_guard<std::mutex> lock(track.mutex);
+        if (complete) {
+            track.chunks.assign(track.chunks.size(), true);
+            track.complete = true;
+        } else {
+            track.failed = true;
+        }
+        track.changed.notify_all();
+        return complete;
+    }
+
+    // Fill a registered partial track, then move it into the cache
+    void FillAndStore(const PartialTrackPtr& track) {
+        bool ok = Fill(*track);
+        std::string finalPath = FilePath(track->videoId, track->ext);
+        std::string partPath = track->path;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        partials.erase(track->videoId);
+        if (ok) {
+            std::lock_guard<std::mutex> trackLock(track->mutex);
+            std::remove(finalPath.c_str());
+            ok = std::rename(partPath.c_str(), finalPath.c_str()) == 0;
+            if (ok) track->path = finalPath;
+        }
+        if (ok && Insert(track->videoId, track->ext, (uint64_t)track->totalSize)) {
+            downloads++;
+            Logger::Log("AudioCache: Stored " + track->videoId + " (" + std::to_string(track->totalSize / 1024) + " KB)");
+            return;
+        }
+        std::remove(partPath.c_str());
+        std::remove(finalPath.c_str());
+        if (!track->cancel->IsCancelled()) Logger::Error("AudioCache: Download failed for " + track->videoId);
+    }
+
+    // Register a new partial track for videoId. Caller holds mutex.
+    PartialTrackPtr CreatePartial(const std::string& videoId, const std::string& url) {
+        PartialTrackPtr track = std::make_shared<PartialTrack>();
+        track->videoId = videoId;
+        track->url = url;
+        track->ext = GuessAudioExtension(url);
+        track->path = FilePath(videoId, track->ext) + ".part";
+        partials[videoId] = track;
+        return track;
+    }
+
+    // Join stream threads that have finished. Caller holds mutex.
+    void PruneStreamFills() {
+        for (auto it = streamFills.begin(); it != streamFills.end();) {
+            if (it->done) {
+                it->thread.join();
+                it = streamFills.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    void DownloadLoop() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            queueCv.wait(lock, [this] { return stopping || !queue.empty(); });
+            if (stopping) break;
+
+            Download job = queue.front();
+            queue.pop_front();
+            queued.erase(job.videoId);
+            // Cached meanwhile, or already streaming
+            if (slots.count(job.videoId) || partials.count(job.videoId)) continue;
+
+            PartialTrackPtr track = CreatePartial(job.videoId, job.url);
+            track->paced = job.predicted;
+            lock.unlock();
+            FillAndStore(track);
+            lock.lock();
+        }
+    }
+
+public:
+    AudioCache(HttpClient& client, const std::string& dir)
+        : http(client), directory(dir), totalBytes(0), useCounter(0), stopping(false),
+          hits(0), misses(0), downloads(0), evictions(0) {}
+
+    ~AudioCache() {
+        Stop();
+    }
+
+    // Map the index and start the download thread
+    void Start() {
+        if (!AudioCacheEnabled || downloadThread.joinable()) return;
+        if (!EnsureDirectory(directory)) {
+            Logger::Error("AudioCache: Cannot create " + directory);
+            return;
+        }
+
+        uint32_t capacity = (uint32_t)std::max(AudioCacheMaxEntries, 1);
+        std::string indexPath = FilePath("index", "bin");
+        if (!index.Open(indexPath, sizeof(IndexHeader) + (size_t)capacity * sizeof(IndexRecord))) {
+            Logger::Error("AudioCache: Cannot map " + indexPath);
+            return;
+        }
+
+        IndexHeader* header = Header();
+        bool valid = memcmp(header->magic, "YTMAUDIO", 8) == 0 && header->version == IndexVersion &&
+            sizeof(IndexHeader) + (size_t)header->capacity * sizeof(IndexRecord) <= index.Size();
+        if (!valid) {
+            memset(index.Data(), 0, index.Size());
+            memcpy(header->magic, "YTMAUDIO", 8);
+            header->version = IndexVersion;
+        }
+        // Keep a larger existing index; a smaller one was zero-extended by Open
+        header->capacity = std::max(valid ? header->capacity : 0, capacity);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (uint32_t slot = header->capacity; slot-- > 0;) {
+                IndexRecord& record = Records()[slot];
+                record.videoId[sizeof(record.videoId) - 1] = 0;
+                record.ext[sizeof(record.ext) - 1] = 0;
+                if (record.videoId[0] == 0 || !IsSafeName(record.videoId, sizeof(record.videoId)) ||
+                    !IsSafeName(record.ext, sizeof(record.ext)) || slots.count(record.videoId)) {
+                    memset(&record, 0, sizeof(record));
+                    freeSlots.push_back(slot);
+                    continue;
+                }
+                slots[record.videoId] = slot;
+                totalBytes += record.size;
+                useCounter = std::max(useCounter, record.lastUse);
+            }
+            stopping = false;
+        }
+        index.Flush();
+        Logger::Log("AudioCache: " + std::to_string(slots.size()) + " tracks, " +
+            std::to_string(totalBytes / (1024 * 1024)) + " MB in " + directory);
+
+        downloadThread = std::thread(&AudioCache::DownloadLoop, this);
+    }
+
+    void Stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+            queue.clear();
+            queued.clear();
+            for (auto& partial : partials) partial.second->cancel->Cancel();
+        }
+        queueCv.notify_all();
+        if (downloadThread.joinable()) downloadThread.join();
+        for (auto& fill : streamFills) fill.thread.join();
+        streamFills.clear();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        index.Flush();
+        index.Close();
+        slots.clear();
+        freeSlots.clear();
+        totalBytes = 0;
+    }
+
+    bool IsRunning() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return index.IsOpen() && !stopping;
+    }
+
+    // Local path of a cached track; refreshes its LRU position. Counts a hit or a miss.
+    bool Lookup(const std::string& videoId, std::string& path) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = slots.find(videoId);
+        if (it == slots.end()) {
+            misses++;
+            Metrics::Count(Metrics::AudioCacheMisses);
+            return false;
+        }
+
+        IndexRecord& record = Records()[it->second];
+        path = RecordPath(record);
+        if (!FileExists(path)) {
+            // Deleted behind our back
+            ReleaseSlot(it->second);
+            misses++;
+            Metrics::Count(Metrics::AudioCacheMisses);
+            return false;
+        }
+        record.lastUse = ++useCounter;
+        hits++;
+        Metrics::Count(Metrics::AudioCacheHits);
+        return true;
+    }
+
+    // Queue a background download of a resolved stream URL. Played tracks
+    // go to the front of the queue, predicted ones to the back.
+    void Enqueue(const std::string& videoId, const std::string& url, bool predicted) {
+        if (url.compare(0, 4, "http") != 0) return;
+        if (!IsSafeName(videoId, sizeof(IndexRecord().videoId))) return;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!downloadThread.joinable() || stopping) return;
+        auto partial = partials.find(videoId);
+        if (partial != partials.end() && !predicted) partial->second->paced = false;
+        if (queued.count(videoId) && !predicted) {
+            // Predicted earlier, played now: move it to the front
+            for (auto it = queue.begin(); it != queue.end(); ++it) {
+                if (it->videoId != videoId) continue;
+                queue.erase(it);
+                queued.erase(videoId);
+                break;
+            }
+        }
+        if (slots.count(videoId) || partial != partials.end() || queued.count(videoId)) return;
+        if (predicted && queue.size() >= MaxQueuedDownloads) return;
+
+        Download job;
+        job.videoId = videoId;
+        job.url = url;
+        job.predicted = predicted;
+        if (predicted) queue.push_back(job);
+        else queue.push_front(job);
+        queued.insert(videoId);
+        while (queue.size() > MaxQueuedDownloads) {
+            queued.erase(queue.back().videoId);
+            queue.pop_back();
+        }
+        queueCv.notify_one();
+    }
+
+    // Start filling a track right away on its own thread so it can be read
+    // while it downloads. Returns false if the cache is not running.
+    bool Stream(const std::string& videoId, const std::string& url) {
+        if (url.compare(0, 4, "http") != 0) return false;
+        if (!IsSafeName(videoId, sizeof(IndexRecord().videoId))) return false;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!downloadThread.joinable() || stopping) return false;
+        PruneStreamFills();
+        auto partial = partials.find(videoId);
+        if (partial != partials.end()) partial->second->paced = false;
+        if (slots.count(videoId) || partial != partials.end()) return true;
+
+        PartialTrackPtr track = CreatePartial(videoId, url);
+        streamFills.emplace_back();
+        StreamFill& fill = streamFills.back();
+        fill.thread = std::thread([this, track, &fill] {
+            FillAndStore(track);
+            fill.done = true;
+        });
+        return true;
+    }
+
+    // The track for a reader: the partial one being filled, or a complete
+    // one made from the cached file. nullptr if neither exists.
+    PartialTrackPtr OpenStream(const std::string& videoId) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto partial = partials.find(videoId);
+        if (partial != partials.end()) return partial->second;
+
+        auto it = slots.find(videoId);
+        if (it == slots.end()) return nullptr;
+        IndexRecord& record = Records()[it->second];
+        record.lastUse = ++useCounter;
+
+        PartialTrackPtr track = std::make_shared<PartialTrack>();
+        track->videoId = videoId;
+        track->ext = record.ext;
+        track->path = RecordPath(record);
+        track->totalSize = (long long)record.size;
+        track->complete = true;
+        return track;
+    }
+
+    std::string StatsString() const {
+        return "hits=" + std::to_string((uint64_t)hits) + " misses=" + std::to_string((uint64_t)misses) +
+            " downloads=" + std::to_string((uint64_t)downloads) + " evictions=" + std::to_string((uint64_t)evictions);
+    }
+};
+
+//////////////////////////////////////////////////////////////////////////
+// Socket and file primitives for the loopback proxy
+#ifdef VDJ_WIN
+typedef SOCKET SocketHandle;
+const SocketHandle InvalidSocket = INVALID_SOCKET;
+
+inline void CloseSocket(SocketHandle s) {
+    closesocket(s);
+}
+
+// Abort blocking calls on the socket from another thread
+inline void ShutdownSocket(SocketHandle s) {
+    shutdown(s, SD_BOTH);
+}
+#else
+typedef int SocketHandle;
+const SocketHandle InvalidSocket = -1;
+
+inline void CloseSocket(SocketHandle s) {
+    close(s);
+}
+
+// Abort blocking calls on the socket from another thread
+inline void ShutdownSocket(SocketHandle s) {
+    shutdown(s, SHUT_RDWR);
+}
+#endif
+
+inline bool SendAll(SocketHandle s, const char* data, size_t size) {
+    while (size > 0) {
+#ifdef VDJ_WIN
+        int sent = send(s, data, (int)std::min(size, (size_t)INT_MAX), 0);
+#else
+        ssize_t sent = send(s, data, size, MSG_NOSIGNAL);
+#endif
+        if (sent <= 0) return false;
+        data += sent;
+        size -= (size_t)sent;
+    }
+    return true;
+}
+
+// Read-only handle on a track file that may still be growing or get
+// renamed while open. SendTo() copies file ranges to a socket inside the
+// kernel (sendfile / TransmitFile) where the platform supports it.
+class TrackFileReader {
+private:
+#ifdef VDJ_WIN
+    HANDLE file;
+#else
+    int fd;
+#endif
+
+public:
+#ifdef VDJ_WIN
+    TrackFileReader() : file(INVALID_HANDLE_VALUE) {}
+    ~TrackFileReader() { if (file != INVALID_HANDLE_VALUE) CloseHandle(file); }
+
+    bool Open(const std::string& path) {
+        file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+            NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+        return file != INVALID_HANDLE_VALUE;
+    }
+
+    bool SendTo(SocketHandle s, long long offset, long long length) {
+        while (length > 0) {
+            DWORD part = (DWORD)std::min(length, (long long)(64 * 1024 * 1024));
+            LARGE_INTEGER position;
+            position.QuadPart = offset;
+            if (!SetFilePointerEx(file, position, NULL, FILE_BEGIN)) return false;
+            if (!TransmitFile(s, file, part, 0, NULL, NULL, 0)) return false;
+            offset += part;
+            length -= part;
+        }
+        return true;
+    }
+#else
+    TrackFileReader() : fd(-1) {}
+    ~TrackFileReader() { if (fd >= 0) close(fd); }
+
+    bool Open(const std::string& path) {
+        fd = open(path.c_str(), O_RDONLY);
+        return fd >= 0;
+    }
+
+    bool SendTo(SocketHandle s, long long offset, long long length) {
+#ifdef __linux__
+        off_t position = (off_t)offset;
+        while (length > 0) {
+            ssize_t sent = sendfile(s, fd, &position, (size_t)std::min(length, (long long)(64 * 1024 * 1024)));
+            if (sent <= 0) return false;
+            length -= sent;
+        }
+        return true;
+#else
+        char buffer[64 * 1024];
+        while (length > 0) {
+            ssize_t got = pread(fd, buffer, (size_t)std::min(length, (long long)sizeof(buffer)), (off_t)offset);
+            if (got <= 0 || !SendAll(s, buffer, (size_t)got)) return false;
+            offset += got;
+            length -= got;
+        }
+        return true;
+#endif
+    }
+#endif
+};
+
+//////////////////////////////////////////////////////////////////////////
+// LoopbackProxy - minimal HTTP server on 127.0.0.1 that VDJ streams tracks
+// from while the AudioCache is still downloading them. Byte ranges are
+// honoured so VDJ can seek; a range that is not on disk yet is fetched
+// ahead of the linear fill. One thread per connection, and every response
+// closes its connection. URLs carry a random prefix chosen at Start, so
+// other local programs cannot read the cache by guessing video ids.
+class LoopbackProxy {
+private:
+    enum {
+        MaxRequestBytes = 8192,
+        WaitTimeoutMs = 20000   // longest wait for data before giving up on a response
+    };
+
+    AudioCache& cache;
+    SocketHandle listener;
+    int port;
+    std::string prefix;     // "/<random hex>/audio/", per session
+    std::thread acceptThread;
+    std::mutex mutex;
+    std::condition_variable idle;
+    std::unordered_set<SocketHandle> clients;
+    bool stopping;
+
+    static const char* ContentType(const std::string& ext) {
+        if (ext == "webm") return "audio/webm";
+        if (ext == "mp3") return "audio/mpeg";
+        if (ext == "ogg") return "audio/ogg";
+        return "audio/mp4";
+    }
+
+    static void SendStatus(SocketHandle s, const char* status) {
+        std::string response = std::string("HTTP/1.1 ") + status +
+            "\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+        SendAll(s, response.data(), response.size());
+    }
+
+    // Parse "bytes=first-last", "bytes=first-" or "bytes=-suffix" against
+    // the track size. Returns false if the range is not satisfiable.
+    static bool ParseRange(const std::string& value, long long total, long long& first, long long& last) {
+        size_t eq = value.find('=');
+        size_t dash = value.find('-');
+        if (eq == std::string::npos || dash == std::string::npos || dash < eq) return false;
+        std::string from = value.substr(eq + 1, dash - eq - 1);
+        std::string to = value.substr(dash + 1, value.find(',') == std::string::npos ? std::string::npos : value.find(',') - dash - 1);
+        if (from.empty()) {
+            long long suffix = strtoll(to.c_str(), nullptr, 10);
+            if (suffix <= 0) return false;
+            first = std::max(0LL, total - suffix);
+            last = total - 1;
+        } else {
+            first = strtoll(from.c_str(), nullptr, 10);
+            last = to.empty() ? total - 1 : std::min(strtoll(to.c_str(), nullptr, 10), total - 1);
+        }
+        return first <= last && first < total;
+    }
+
+    void Serve(SocketHandle client) {
+        std::string request;
+        char buffer[2048];
+        while (request.find("\r\n\r\n") == std::string::npos) {
+            int got = (int)recv(client, buffer, sizeof(buffer), 0);
+            if (got <= 0 || request.size() > MaxRequestBytes) return;
+            request.append(buffer, got);
+        }
+
+        // "GET /<prefix>/audio/<videoId>.<ext> HTTP/1.1"
+        std::istringstream requestLine(request.substr(0, request.find("\r\n")));
+        std::string method, target;
+        requestLine >> method >> target;
+        if (method != "GET" && method != "HEAD") {
+            SendStatus(client, "405 Method Not Allowed");
+            return;
+        }
+        std::string name = target.compare(0, prefix.size(), prefix) == 0 ? target.substr(prefix.size()) : "";
+        std::string videoId = name.substr(0, name.find('.'));
+        PartialTrackPtr track = videoId.empty() ? nullptr : cache.OpenStream(videoId);
+        if (!track) {
+            SendStatus(client, "404 Not Found");
+            return;
+        }
+
+        long long total = track->WaitForSize(WaitTimeoutMs);
+        if (total < 0) {
+            SendStatus(client, "502 Bad Gateway");
+            return;
+        }
+
+        std::string range;
+        std::string lower = request;
+        for (auto& c : lower) c = (char)tolower((unsigned char)c);
+        size_t rangePos = lower.find("\r\nrange:");
+        if (rangePos != std::string::npos) {
+            size_t valueStart = rangePos + 8;
+            range = request.substr(valueStart, request.find("\r\n", valueStart) - valueStart);
+        }
+
+        long long first = 0;
+        long long last = total - 1;
+        std::string header;
+        if (!range.empty()) {
+            if (!ParseRange(range, total, first, last)) {
+                header = "HTTP/1.1 416 Range Not Satisfiable\r\nContent-Range: bytes */" + std::to_string(total) +
+                    "\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+                SendAll(client, header.data(), header.size());
+                return;
+            }
+            header = "HTTP/1.1 206 Partial Content\r\nContent-Range: bytes " + std::to_string(first) + "-" +
+                std::to_string(last) + "/" + std::to_string(total) + "\r\n";
+        } else {
+            header = "HTTP/1.1 200 OK\r\n";
+        }
+        header += std::string("Content-Type: ") + ContentType(track->ext) + "\r\nAccept-Ranges: bytes\r\n"
+            "Content-Length: " + std::to_string(last - first + 1) + "\r\nConnection: close\r\n\r\n";
+        if (!SendAll(client, header.data(), header.size()) || method == "HEAD") return;
+
+        TrackFileReader reader;
+        {
+            std::lock_guard<std::mutex> lock(track->mutex);
+            if (!reader.Open(track->path)) return;
+        }
+        long long position = first;
+        while (position <= last) {
+            long long available = track->WaitAvailable(position, WaitTimeoutMs);
+            if (available <= 0) break;
+            long long length = std::min(available, last - position + 1);
+            if (!reader.SendTo(client, position, length)) break;
+            position += length;
+        }
+        if (position <= last) YTLOG_DEBUG("LoopbackProxy: Response for " + videoId + " ended early");
+    }
+
+    void ServeAndClose(SocketHandle client) {
+#ifndef VDJ_WIN
+        // A peer that hangs up must not kill the host with SIGPIPE (sendfile
+        // cannot take MSG_NOSIGNAL); a blocked signal is dropped with the thread.
+        sigset_t pipeSignal;
+        sigemptyset(&pipeSignal);
+        sigaddset(&pipeSignal, SIGPIPE);
+        pthread_sigmask(SIG_BLOCK, &pipeSignal, nullptr);
+#endif
+        Serve(client);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            clients.erase(client);
+            CloseSocket(client);
+        }
+        idle.notify_all();
+    }
+
+    void AcceptLoop() {
+        while (true) {
+            SocketHandle client = accept(listener, nullptr, nullptr);
+            std::lock_guard<std::mutex> lock(mutex);
+            if (stopping) {
+                if (client != InvalidSocket) CloseSocket(client);
+                return;
+            }
+            if (client == InvalidSocket) continue;
+            clients.insert(client);
+            std::thread(&LoopbackProxy::ServeAndClose, this, client).detach();
+        }
+    }
+
+public:
+    explicit LoopbackProxy(AudioCache& audioCache)
+        : cache(audioCache), listener(InvalidSocket), port(0), stopping(false) {}
+
+    ~LoopbackProxy() {
+        Stop();
+    }
+
+    // Listen on 127.0.0.1 (ProxyPort, or any free port if 0)
+    bool Start() {
+        if (!ProgressiveProxyEnabled || acceptThread.joinable()) return false;
+#ifdef VDJ_WIN
+        WSADATA wsaData;
+        if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0) return false;
+#endif
+        listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        sockaddr_in address;
+        memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = htons((unsigned short)ProxyPort);
+        socklen_t addressSize = sizeof(address);
+        if (listener == InvalidSocket ||
+            bind(listener, (sockaddr*)&address, sizeof(address)) != 0 ||
+            listen(listener, 16) != 0 ||
+            getsockname(listener, (sockaddr*)&address, &addressSize) != 0) {
+            Logger::Error("LoopbackProxy: Cannot listen on 127.0.0.1:" + std::to_string(ProxyPort));
+            if (listener != InvalidSocket) CloseSocket(listener);
+            listener = InvalidSocket;
+#ifdef VDJ_WIN
+            WSACleanup();
+#endif
+            return false;
+        }
+
+        port = ntohs(address.sin_port);
+        std::random_device random;
+        char token[17];
+        snprintf(token, sizeof(token), "%08x%08x", (unsigned)random(), (unsigned)random());
+        prefix = std::string("/") + token + "/audio/";
+        stopping = false;
+        acceptThread = std::thread(&LoopbackProxy::AcceptLoop, this);
+        Logger::Log("LoopbackProxy: Listening on 127.0.0.1:" + std::to_string(port));
+        return true;
+    }
+
+    // Stop the AudioCache first so connections waiting for data give up
+    void Stop() {
+        if (!acceptThread.joinable()) return;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+            ShutdownSocket(listener);
+            CloseSocket(listener);
+            // Unblock connection threads; each one closes its own socket
+            for (SocketHandle client : clients) ShutdownSocket(client);
+        }
+        acceptThread.join();
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            idle.wait(lock, [this] { return clients.empty(); });
+        }
+        listener = InvalidSocket;
+#ifdef VDJ_WIN
+        WSACleanup();
+#endif
+    }
+
+    bool IsRunning() const { return acceptThread.joinable(); }
+
+    std::string UrlFor(const std::string& videoId, const std::string& ext) const {
+        return "http://127.0.0.1:" + std::to_string(port) + prefix + videoId + "." + ext;
+    }
+};
+
+//////////////////////////////////////////////////////////////////////////
+// StreamUrlPrefetcher - speculatively resolves stream URLs for the top
+// search results into the StreamUrlCache so GetStreamUrl can answer without
+// a /get_url round-trip. The first AudioCachePrefetchCount of them are also
+// queued for download into the AudioCache. Each Start() begins a new
+// generation; queued work from an older generation is dropped as soon as a
+// worker picks it up.
+class StreamUrlPrefetcher {
+private:
+    HttpClient& http;
+    WorkerPool& workers;
+    StreamUrlCache& cache;
+    AudioCache& audio;
+    std::atomic<unsigned> generation;
+    std::mutex tokenMutex;
+    CancelTokenPtr token;   // aborts in-flight requests of the current generation
+
+    void Resolve(const std::string& videoId, unsigned gen, const CancelTokenPtr& cancel, bool download) {
+        if (generation != gen) return;
+
+        std::string url;
+        if (!cache.Contains(videoId, &url)) {
+            HttpRequestOptions options;
+            options.background = true;
+            options.cancel = cancel;
+            std::string response = http.Get("/get_url?id=" + videoId, options);
+            if (generation != gen) return;
+
+            StreamUrlInfo info;
+            if (!ParseStreamUrlResponse(response, info)) return;
+            cache.Store(videoId, info);
+            url = info.url;
+            Logger::Log("Prefetch: Resolved " + videoId);
+        }
+        if (download) audio.Enqueue(videoId, url, true);
+    }
+
+public:
+    StreamUrlPrefetcher(HttpClient& client, WorkerPool& pool, StreamUrlCache& urlCache, AudioCache& audioCache)
+        : http(client), workers(pool), cache(urlCache), audio(audioCache), generation(0) {}
+
+    // Replace any running prefetch with the first `count` of these ids
+    void Start(const std::vector<std::string>& videoIds, int count) {
+        CancelTokenPtr cancel = std::make_shared<CancelToken>();
+        unsigned gen;
+        {
+            std::lock_guard<std::mutex> lock(tokenMutex);
+            gen = ++generation;
+            if (token) token->Cancel();
+            token = cancel;
+        }
+        if (count <= 0) return;
+
+        int queued = 0;
+        for (const auto& id : videoIds) {
+            if (queued >= count) break;
+            bool download = queued < AudioCachePrefetchCount;
+            workers.Submit([this, id, gen, cancel, download] { Resolve(id, gen, cancel, download); });
+            queued++;
+        }
+    }
+
+    void Cancel() {
+        std::lock_guard<std::mutex> lock(tokenMutex);
+        ++generation;
+        if (token) token->Cancel();
+        token.reset();
+    }
+};
+
+//////////////////////////////////////////////////////////////////////////
+// NextTrackPrefetcher - warms the tracks that follow a loaded one in the
+// open playlist. GetStreamUrl reports every videoId it is asked for; when
+// the id is in the playlist, the stream URLs of the next
+// NextTrackPrefetchCount tracks are resolved into the StreamUrlCache on
+// NextTrackPrefetchThreads workers (joining a pending /get_urls batch when
+// there is one), and the first NextTrackAudioCount of
+// them are queued as predicted downloads in the AudioCache (paced to
+// PrefetchBandwidthKBps until loaded). Loading a warmed track counts as a
+// hit, loading any other track of the playlist as a miss.
+class NextTrackPrefetcher {
+private:
+    HttpClient& http;
+    StreamUrlCache& cache;
+    StreamUrlBatcher& batcher;
+    AudioCache& audio;
+    std::mutex mutex;
+    TrackTablePtr playlist;
+    std::unordered_map<std::string, size_t> positions;     // videoId -> first row in playlist
+    std::unordered_set<std::string> warmed;                // predicted, not loaded yet
+    std::atomic<unsigned> generation;
+    CancelTokenPtr cancel;
+    std::unique_ptr<WorkerPool> pool;
+
+    std::atomic<uint64_t> hits;
+    std::atomic<uint64_t> misses;
+    std::atomic<uint64_t> resolved;
+
+    void Warm(const std::string& videoId, unsigned gen, bool download) {
+        if (generation != gen) return;
+
+        std::string url;
+        StreamUrlInfo info;
+        if (!cache.Contains(videoId, &url)) {
+            // Already in a playlist batch: let it resolve the id at its own pace
+            auto abandoned = [this, gen] { return generation != gen || cancel->IsCancelled(); };
+            if (batcher.WaitQueued(videoId, info, abandoned)) {
+                url = info.url;
+            } else {
+                if (abandoned()) return;
+                HttpRequestOptions options;
+                options.background = true;
+                options.cancel = cancel;
+                std::string response = http.Get("/get_url?id=" + videoId, options);
+
+                if (!ParseStreamUrlResponse(response, info)) return;
+                cache.Store(videoId, info);
+                url = info.url;
+                resolved++;
+                Logger::Log("NextTrackPrefetcher: Resolved " + videoId);
+            }
+        }
+        if (download && generation == gen) audio.Enqueue(videoId, url, true);
+    }
+
+public:
+    NextTrackPrefetcher(HttpClient& client, StreamUrlCache& urlCache, StreamUrlBatcher& urlBatcher, AudioCache& audioCache)
+        : http(client), cache(urlCache), batcher(urlBatcher), audio(audioCache), generation(0),
+          cancel(std::make_shared<CancelToken>()), hits(0), misses(0), resolved(0) {}
+
+    ~NextTrackPrefetcher() {
+        Stop();
+    }
+
+    void Start() {
+        if (pool || NextTrackPrefetchCount <= 0) return;
+        pool.reset(new WorkerPool(NextTrackPrefetchThreads));
+    }
+
+    void Stop() {
+        if (!pool) return;
+        ++generation;
+        cancel->Cancel();
+        pool->Shutdown();
+    }
+
+    // The playlist whose order predicts the next loads
+    void SetPlaylist(const TrackTablePtr& tracks) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (tracks == playlist) return;
+        ++generation;
+        playlist = tracks;
+        positions.clear();
+        warmed.clear();
+        if (!playlist) return;
+        positions.reserve(playlist->Size());
+        for (size_t row = 0; row < playlist->Size(); row++) {
+            positions.emplace(playlist->Str((*playlist)[row].videoId), row);
+        }
+    }
+
+    // A track is being loaded: score the last prediction and warm the
+    // tracks after it. Queued work for an older prediction is dropped.
+    void TrackLoaded(const std::string& videoId) {
+        if (!pool) return;
+        std::vector<std::string> next;
+        unsigned gen;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = positions.find(videoId);
+            if (it == positions.end()) return;
+            if (warmed.erase(videoId)) {
+                hits++;
+                Metrics::Count(Metrics::NextTrackHits);
+            } else {
+                misses++;
+                Metrics::Count(Metrics::NextTrackMisses);
+            }
+
+            for (size_t row = it->second + 1; row < playlist->Size() && (int)next.size() < NextTrackPrefetchCount; row++) {
+                std::string id = playlist->Str((*playlist)[row].videoId);
+                if (id != videoId) next.push_back(id);
+            }
+            gen = ++generation;
+            warmed.insert(next.begin(), next.end());
+        }
+        for (size_t i = 0; i < next.size(); i++) {
+            std::string id = next[i];
+            bool download = (int)i < NextTrackAudioCount;
+            pool->Submit([this, id, gen, download] { Warm(id, gen, download); });
+        }
+    }
+
+    std::string StatsString() const {
+        uint64_t scored = hits + misses;
+        return "hits=" + std::to_string((uint64_t)hits) + " misses=" + std::to_string((uint64_t)misses) +
+            " hit_rate=" + std::to_string(scored ? hits * 100 / scored : 0) + "%" +
+            " resolved=" + std::to_string((uint64_t)resolved);
+    }
+};
+
+//////////////////////////////////////////////////////////////////////////
+// SearchCache - bounded LRU of parsed search results keyed by normalized
+// query. Entries are served instantly and revalidated in the background
+// (stale-while-revalidate) so the next hit sees fresh results.
+class SearchCache {
+private:
+    struct Entry {
+        std::string key;
+        TrackTablePtr tracks;
+        size_t bytes;
+        std::chrono::steady_clock::time_point storedAt;
+        bool revalidating;
+    };
+
+    std::mutex mutex;
+    std::list<Entry> lru;   // most recently used first
+    std::unordered_map<std::string, std::list<Entry>::iterator> index;
+    size_t totalBytes;
+    size_t maxEntries;
+    size_t maxBytes;
+
+    void EraseLocked(std::list<Entry>::iterator it) {
+        totalBytes -= it->bytes;
+        index.erase(it->key);
+        lru.erase(it);
+    }
+
+public:
+    SearchCache(size_t entryLimit, size_t byteLimit)
+        : totalBytes(0), maxEntries(entryLimit), maxBytes(byteLimit) {}
+
+    // Lower-case, trim and collapse whitespace so "Daft  Punk " == "daft punk"
+    static std::string NormalizeQuery(const std::string& query) {
+        std::string key;
+        key.reserve(query.size());
+        bool pendingSpace = false;
+        for (unsigned char c : query) {
+            if (isspace(c)) {
+                pendingSpace = !key.empty();
+                continue;
+            }
+            if (pendingSpace) key += ' ';
+            pendingSpace = false;
+            key += (char)tolower(c);
+        }
+        return key;
+    }
+
+    // Returns the cached results (or null). needsRevalidation is set when the
+    // entry is older than maxAgeSeconds and no revalidation is running yet;
+    // the caller then owns the revalidation and must call Put() or
+    // RevalidationFailed().
+    TrackTablePtr Get(const std::string& key, int maxAgeSeconds, bool& needsRevalidation) {
+        needsRevalidation = false;
+        std::lock_guard<std::mutex> lock(mutex);
+        auto found = index.find(key);
+        if (found == index.end()) return TrackTablePtr();
+
+        lru.splice(lru.begin(), lru, found->second);
+        Entry& entry = *found->second;
+        auto age = std::chrono::steady_clock::now() - entry.storedAt;
+        if (!entry.revalidating && age >= std::chrono::seconds(maxAgeSeconds)) {
+            entry.revalidating = true;
+            needsRevalidation = true;
+        }
+        return entry.tracks;
+    }
+
+    void Put(const std::string& key, const TrackTablePtr& tracks) {
+        size_t bytes = tracks->Bytes() + key.capacity();
+        if (bytes > maxBytes) return;
+
+        Entry entry;
+        entry.key = key;
+        entry.tracks = tracks;
+        entry.bytes = bytes;
+        entry.storedAt = std::chrono::steady_clock::now();
+        entry.revalidating = false;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        auto found = index.find(key);
+        if (found != index.end()) EraseLocked(found->second);
+
+        lru.push_front(std::move(entry));
+        index[key] = lru.begin();
+        totalBytes += bytes;
+
+        while (!lru.empty() && (lru.size() > maxEntries || totalBytes > maxBytes)) {
+            EraseLocked(std::prev(lru.end()));
+        }
+    }
+
+    void RevalidationFailed(const std::string& key) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto found = index.find(key);
+        if (found != index.end()) found->second->revalidating = false;
+    }
+};
+
+//////////////////////////////////////////////////////////////////////////
+// PlaylistTrackCache - parsed tracks per playlistId, in playlist order.
+// An entry may be partial while the remaining pages load in the background.
+class PlaylistTrackCache {
+public:
+    struct Snapshot {
+        TrackTablePtr tracks;
+        bool complete;      // every page has been loaded
+        bool loading;       // a background load is still filling this entry
+        std::chrono::steady_clock::time_point loadedAt;
+        HttpValidators validators;  // of the first page; its ETag versions the whole playlist
+    };
+
+private:
+    std::mutex mutex;
+    std::unordered_map<std::string, Snapshot> entries;
+
+public:
+    bool Get(const std::string& playlistId, Snapshot& out) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = entries.find(playlistId);
+        if (it == entries.end() || !it->second.tracks) return false;
+        out = it->second;
+        return true;
+    }
+
+    void Put(const std::string& playlistId, const TrackTablePtr& tracks, bool complete,
+             const HttpValidators& validators) {
+        std::lock_guard<std::mutex> lock(mutex);
+        Snapshot& entry = entries[playlistId];
+        entry.tracks = tracks;
+        entry.complete = complete;
+        entry.loadedAt = std::chrono::steady_clock::now();
+        entry.validators = validators;
+    }
+
+    // The bridge confirmed the cached entry is current; restart its freshness window
+    void Touch(const std::string& playlistId) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = entries.find(playlistId);
+        if (it != entries.end()) it->second.loadedAt = std::chrono::steady_clock::now();
+    }
+
+    // Claim the background load for a playlist; false if one is already running
+    bool TryBeginLoad(const std::string& playlistId) {
+        std::lock_guard<std::mutex> lock(mutex);
+        Snapshot& entry = entries[playlistId];
+        if (entry.loading) return false;
+        entry.loading = true;
+        return true;
+    }
+
+    void EndLoad(const std::string& playlistId) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = entries.find(playlistId);
+        if (it != entries.end()) it->second.loading = false;
+    }
+};
+
+//////////////////////////////////////////////////////////////////////////
+// PlaylistStore - fully loaded playlists on disk with the snapshot (ETag)
+// they were loaded at, so after a restart a playlist is brought up to date
+// with a /playlist_delta request instead of being fetched again in full.
+// One file per playlist:
+//   "YTMPLIST", u32 version, string playlistId, string snapshot, u32 count,
+//   then count track records (strings and records as in RecordReader)
+// The list of the user's playlists is kept next to them in lists.bin, so
+// GetFolderList has something to show before the bridge answers:
+//   "YTMLISTS", u32 version, u32 count,
+//   then per playlist: string playlistId, string title, u32 count, string thumbnail
+class PlaylistStore {
+private:
+    enum { Version = 1 };
+
+    std::string directory;
+    std::mutex mutex;       // serializes writers of the same file
+
+    std::string ListPath() const {
+        return directory + "/lists.bin";
+    }
+
+    std::string FilePath(const std::string& playlistId) const {
+        char name[32];
+        snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)HashBytes(playlistId.data(), playlistId.size()));
+        return directory + "/" + name;
+    }
+
+    static void WriteU32(std::string& out, uint32_t value) {
+        for (int i = 0; i < 4; i++) out += (char)((value >> (8 * i)) & 0xFF);
+    }
+
+    static void WriteString(std::string& out, const std::string& value) {
+        size_t size = std::min(value.size(), (size_t)0xFFFF);
+        out += (char)(size & 0xFF);
+        out += (char)(size >> 8);
+        out.append(value, 0, size);
+    }
+
+    // Replace a file through a temporary one, so readers never see half of it
+    void WriteFile(const std::string& path, const std::string& bytes) {
+        if (!EnsureDirectory(directory)) return;
+        std::lock_guard<std::mutex> lock(mutex);
+        std::string tempPath = path + ".tmp";
+        {
+            std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+            if (!file.is_open()) return;
+            file.write(bytes.data(), (std::streamsize)bytes.size());
+            if (!file.good()) {
+                file.close();
+                std::remove(tempPath.c_str());
+                return;
+            }
+        }
+        std::remove(path.c_str());
+        std::rename(tempPath.c_str(), path.c_str());
+    }
+
+public:
+    explicit PlaylistStore(const std::string& dir) : directory(dir) {}
+
+    // False if the playlist is not stored or its file is damaged
+    bool Load(const std::string& playlistId, TrackTablePtr& tracks, std::string& snapshot) {
+        std::string bytes;
+        {
+            std::ifstream file(FilePath(playlistId), std::ios::binary);
+            if (!file.is_open()) return false;
+            bytes.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        }
+        if (bytes.size() < 12 || memcmp(bytes.data(), "YTMPLIST", 8) != 0) return false;
+
+        RecordReader reader(bytes.data() + 8, bytes.size() - 8);
+        uint32_t version, count;
+        std::string storedId;
+        if (!reader.ReadU32(version) || version != Version || !reader.ReadString(storedId) ||
+            storedId != playlistId || !reader.ReadString(snapshot) || !reader.ReadU32(count) ||
+            count > bytes.size() / RecordReader::MinTrackSize) {
+            return false;
+        }
+
+        std::shared_ptr<TrackTable> table = std::make_shared<TrackTable>();
+        table->Reserve(bytes.size(), count);
+        for (uint32_t i = 0; i < count; i++) {
+            if (!ReadTrackRecord(reader, *table)) return false;
+        }
+        tracks = table;
+        return true;
+    }
+
+    void Save(const std::string& playlistId, const TrackTable& tracks, const std::string& snapshot) {
+        std::string bytes = "YTMPLIST";
+        WriteU32(bytes, Version);
+        WriteString(bytes, playlistId);
+        WriteString(bytes, snapshot);
+        WriteU32(bytes, (uint32_t)tracks.Size());
+        for (const auto& track : tracks) WriteTrackRecord(bytes, tracks, track);
+        WriteFile(FilePath(playlistId), bytes);
+    }
+
+    // False if no list is stored or its file is damaged
+    bool LoadList(std::vector<Playlist>& playlists) {
+        std::string bytes;
+        {
+            std::ifstream file(ListPath(), std::ios::binary);
+            if (!file.is_open()) return false;
+            bytes.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        }
+        if (bytes.size() < 16 || memcmp(bytes.data(), "YTMLISTS", 8) != 0) return false;
+
+        RecordReader reader(bytes.data() + 8, bytes.size() - 8);
+        uint32_t version, count;
+        if (!reader.ReadU32(version) || version != Version || !reader.ReadU32(count) || count > bytes.size()) {
+            return false;
+        }
+        std::vector<Playlist> loaded(count);
+        for (auto& playlist : loaded) {
+            uint32_t trackCount;
+            if (!reader.ReadString(playlist.playlistId) || !reader.ReadString(playlist.title) ||
+                !reader.ReadU32(trackCount) || !reader.ReadString(playlist.thumbnail)) {
+                return false;
+            }
+            playlist.count = (int)std::min(trackCount, (uint32_t)INT_MAX);
+        }
+        playlists.swap(loaded);
+        return true;
+    }
+
+    void SaveList(const std::vector<Playlist>& playlists) {
+        std::string bytes = "YTMLISTS";
+        WriteU32(bytes, Version);
+        WriteU32(bytes, (uint32_t)playlists.size());
+        for (const auto& playlist : playlists) {
+            WriteString(bytes, playlist.playlistId);
+            WriteString(bytes, playlist.title);
+            WriteU32(bytes, (uint32_t)std::max(playlist.count, 0));
+            WriteString(bytes, playlist.thumbnail);
+        }
+        WriteFile(ListPath(), bytes);
+    }
+
+};
+
+//////////////////////////////////////////////////////////////////////////
+// TrigramSignature - 256-bit fingerprint of the letter trigrams of a text,
+// for typo-tolerant matching. Text is lowercased and padded with spaces
+// ("daft punk" -> " da", "daf", ... "nk "), and each trigram sets one bit.
+// The share of a query's bits that a track also has estimates how many of
+// the query's trigrams it contains, so "daft pnuk" still finds Daft Punk.
+// Comparing is an AND and a popcount over four words. On x86-64, Scan
+// picks its kernel when first used: AVX2 (one register, nibble-table
+// popcount) or the POPCNT instruction when the CPU has them, plain C++
+// otherwise, so one build scans a million tracks in a few milliseconds
+// on any recent CPU.
+#if defined(__x86_64__) || defined(_M_X64)
+#define TRIGRAM_X86 1
+#endif
+#if defined(__GNUC__) || defined(__clang__)
+#define TRIGRAM_TARGET(features) __attribute__((target(features)))
+#else
+#define TRIGRAM_TARGET(features)
+#endif
+
+struct TrigramSignature {
+    uint64_t bits[4];
+
+    enum Kernel { KernelScalar, KernelPopcnt, KernelAvx2 };     // slowest to fastest
+    typedef std::vector<std::pair<int, uint32_t>> Matches;      // (shared bits, index)
+
+    TrigramSignature() { memset(bits, 0, sizeof(bits)); }
+
+    // Add the trigrams of a text (call once per field)
+    void AddText(const char* text) {
+        unsigned char window[3] = { ' ', ' ', ' ' };
+        bool pendingSpace = false;
+        for (const char* p = text;; p++) {
+            unsigned char c = (unsigned char)*p;
+            bool word = c >= 0x80 || isalnum(c);
+            if (!word && c) {
+                pendingSpace = true;
+                continue;
+            }
+            if (pendingSpace || !c) {
+                // Word boundary: one space, never several
+                if (window[2] != ' ') Push(window, ' ');
+                pendingSpace = false;
+            }
+            if (!c) break;
+            Push(window, (unsigned char)(c < 0x80 ? tolower(c) : c));
+        }
+    }
+
+    int Count() const {
+        return PopCount64(bits[0]) + PopCount64(bits[1]) + PopCount64(bits[2]) + PopCount64(bits[3]);
+    }
+
+    // Bits set in both signatures
+    int CommonBits(const TrigramSignature& other) const {
+        return PopCount64(bits[0] & other.bits[0]) + PopCount64(bits[1] & other.bits[1]) +
+               PopCount64(bits[2] & other.bits[2]) + PopCount64(bits[3] & other.bits[3]);
+    }
+
+    // Append every signature sharing at least minCommon bits with wanted to
+    // matches, using the given kernel (one this CPU supports)
+    static void Scan(const TrigramSignature* signatures, uint32_t count, const TrigramSignature& wanted,
+                     int minCommon, Matches& matches, Kernel kernel = BestKernel()) {
+#ifdef TRIGRAM_X86
+        if (kernel == KernelAvx2) {
+            ScanAvx2(signatures, count, wanted, minCommon, matches);
+            return;
+        }
+        if (kernel == KernelPopcnt) {
+            ScanPopcnt(signatures, count, wanted, minCommon, matches);
+            return;
+        }
+#endif
+        for (uint32_t i = 0; i < count; i++) {
+            int common = signatures[i].CommonBits(wanted);
+            if (common >= minCommon) matches.emplace_back(common, i);
+        }
+    }
+
+    // The fastest kernel this CPU supports, detected once
+    static Kernel BestKernel() {
+        static const Kernel best = DetectKernel();
+        return best;
+    }
+
+    static const char* KernelName(Kernel kernel) {
+        return kernel == KernelAvx2 ? "avx2" : kernel == KernelPopcnt ? "popcnt" : "scalar";
+    }
+
+    static int PopCount64(uint64_t v) {
+#if defined(_MSC_VER) && defined(__AVX__)
+        return (int)__popcnt64(v);
+#elif defined(__GNUC__)
+        return __builtin_popcountll(v);
+#else
+        v = v - ((v >> 1) & 0x5555555555555555ULL);
+        v = (v & 0x3333333333333333ULL) + ((v >> 2) & 0x3333333333333333ULL);
+        v = (v + (v >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+        return (int)((v * 0x0101010101010101ULL) >> 56);
+#endif
+    }
+
+private:
+    static Kernel DetectKernel() {
+#if defined(TRIGRAM_X86) && (defined(__GNUC__) || defined(__clang__)) && !defined(_MSC_VER)
+        __builtin_cpu_init();
+        if (!__builtin_cpu_supports("popcnt")) return KernelScalar;
+        return __builtin_cpu_supports("avx2") ? KernelAvx2 : KernelPopcnt;
+#elif defined(TRIGRAM_X86) && defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 0);
+        int maxLeaf = info[0];
+        __cpuid(info, 1);
+        if (!(info[2] & (1 << 23))) return KernelScalar;                    // POPCNT
+        bool osSavesAvx = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) &&  // OSXSAVE, AVX
+                          (_xgetbv(0) & 6) == 6;                             // XMM and YMM state
+        if (!osSavesAvx || maxLeaf < 7) return KernelPopcnt;
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) ? KernelAvx2 : KernelPopcnt;            // AVX2
+#else
+        return KernelScalar;
+#endif
+    }
+
+#ifdef TRIGRAM_X86
+    TRIGRAM_TARGET("popcnt") static int HardwarePopCount(uint64_t v) {
+#ifdef _MSC_VER
+        return (int)__popcnt64(v);
+#else
+        return __builtin_popcountll(v);
+#endif
+    }
+
+    TRIGRAM_TARGET("popcnt") static void ScanPopcnt(const TrigramSignature* signatures, uint32_t count,
+                                                    const TrigramSignature& wanted, int minCommon, Matches& matches) {
+        const uint64_t w0 = wanted.bits[0], w1 = wanted.bits[1], w2 = wanted.bits[2], w3 = wanted.bits[3];
+        for (uint32_t i = 0; i < count; i++) {
+            const uint64_t* b = signatures[i].bits;
+            int common = HardwarePopCount(b[0] & w0) + HardwarePopCount(b[1] & w1) +
+                         HardwarePopCount(b[2] & w2) + HardwarePopCount(b[3] & w3);
+            if (common >= minCommon) matches.emplace_back(common, i);
+        }
+    }
+
+    TRIGRAM_TARGET("avx2,popcnt") static void ScanAvx2(const TrigramSignature* signatures, uint32_t count,
+                                                       const TrigramSignature& wanted, int minCommon, Matches& matches) {
+        const __m256i lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                                0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+        const __m256i lowMask = _mm256_set1_epi8(0x0f);
+        const __m256i want = _mm256_loadu_si256((const __m256i*)wanted.bits);
+        for (uint32_t i = 0; i < count; i++) {
+            __m256i both = _mm256_and_si256(_mm256_loadu_si256((const __m256i*)signatures[i].bits), want);
+            __m256i counts = _mm256_add_epi8(
+                _mm256_shuffle_epi8(lookup, _mm256_and_si256(both, lowMask)),
+                _mm256_shuffle_epi8(lookup, _mm256_and_si256(_mm256_srli_epi16(both, 4), lowMask)));
+            __m256i sums = _mm256_sad_epu8(counts, _mm256_setzero_si256());
+            int common = (int)(_mm256_extract_epi64(sums, 0) + _mm256_extract_epi64(sums, 1) +
+                               _mm256_extract_epi64(sums, 2) + _mm256_extract_epi64(sums, 3));
+            if (common >= minCommon) matches.emplace_back(common, i);
+        }
+    }
+#endif
+
+    void Push(unsigned char* window, unsigned char c) {
+        window[0] = window[1];
+        window[1] = window[2];
+        window[2] = c;
+        if (window[0] == ' ' && window[1] == ' ') return;   // not a trigram yet
+        uint32_t hash = (window[0] * 0x9E3779B1u) ^ (window[1] * 0x85EBCA77u) ^ (window[2] * 0xC2B2AE3Du);
+        hash ^= hash >> 15;
+        hash *= 0x2C1B3C6Du;
+        hash ^= hash >> 12;
+        unsigned bit = hash & 255;
+        bits[bit >> 6] |= 1ULL << (bit & 63);
+    }
+};
+
+//////////////////////////////////////////////////////////////////////////
+// LocalTrackIndex - every track the plugin has seen (search results and
+// playlist tracks), so a search can be answered from disk in milliseconds
+// and still works while the bridge is down. Tracks are appended to
+// track_index.bin as binary track records (see RecordReader) behind a small
+// header; the file is memory-mapped and only ever grows at the end. A track
+// seen again with different details gets a new record and the old one
+// becomes garbage. When garbage outweighs live records, or the file passes
+// LocalIndexMaxBytes, the live records are rewritten (newest kept first
+// when over the cap). The inverted index over title, artist and album
+// tokens is rebuilt from the mapped records at startup and kept in memory,
+// next to a trigram signature per record for FuzzySearch(). Compaction
+// copies and re-indexes the live records without holding the lock, so
+// searches keep using the old tables until the new ones are swapped in.
+class LocalTrackIndex {
+private:
+    enum {
+        HeaderSize = 32,            // "YTMINDEX", u32 version, u32 reserved, u64 dataEnd, u64 reserved
+        Version = 1,
+        MinFileSize = 256 * 1024,
+        MinCompactBytes = 1024 * 1024,
+        MinFuzzyTrigrams = 4        // shorter queries would match almost anything
+    };
+
+    struct Record {
+        uint32_t offset;            // in the file
+        uint32_t length;
+        bool live;
+    };
+
+    // In-memory lookup state over the records of one file
+    struct Tables {
+        std::vector<Record> records;    // in file order, so higher ids are newer
+        std::vector<TrigramSignature> signatures;                   // per record: title and artist
+        std::unordered_map<std::string, uint32_t> byVideoId;        // -> id of the live record
+        std::map<std::string, std::vector<uint32_t>> postings;      // token -> ascending record ids
+        uint64_t liveBytes;
+
+        Tables() : liveBytes(0) {}
+    };
+
+    std::string path;
+    std::mutex mutex;
+    MappedFile file;
+    uint64_t dataEnd;
+    Tables tables;
+    bool compacting;                // a Compact() is running outside the lock
+    std::atomic<bool> ready;        // searches skip the index until Open() has loaded it
+
+    // Lowercased words of a string: ASCII letters and digits, plus any UTF-8
+    // bytes, so non-Latin titles are matched as whole byte sequences
+    static void Tokenize(const char* text, std::vector<std::string>& tokens) {
+        std::string token;
+        for (const char* p = text;; p++) {
+            unsigned char c = (unsigned char)*p;
+            if (c >= 0x80 || isalnum(c)) {
+                token += (char)(c < 0x80 ? tolower(c) : c);
+                continue;
+            }
+            if (!token.empty()) {
+                tokens.push_back(token);
+                token.clear();
+            }
+            if (!c) break;
+        }
+    }
+
+    uint64_t ReadDataEnd() const {
+        uint64_t value;
+        memcpy(&value, file.Data() + 16, sizeof(value));
+        return value;
+    }
+
+    void WriteDataEnd(uint64_t value) {
+        memcpy(file.Data() + 16, &value, sizeof(value));
+        dataEnd = value;
+    }
+
+    // Map the file, writing a fresh header if it is new or unreadable
+    bool MapFile() {
+        if (!file.Open(path, MinFileSize)) return false;
+        uint32_t version;
+        memcpy(&version, file.Data() + 8, sizeof(version));
+        if (memcmp(file.Data(), "YTMINDEX", 8) != 0 || version != Version ||
+            ReadDataEnd() < HeaderSize || ReadDataEnd() > file.Size()) {
+            memset(file.Data(), 0, HeaderSize);
+            memcpy(file.Data(), "YTMINDEX", 8);
+            version = Version;
+            memcpy(file.Data() + 8, &version, sizeof(version));
+            WriteDataEnd(HeaderSize);
+        }
+        dataEnd = ReadDataEnd();
+        return true;
+    }
+
+    // Add the tokens of a record to the inverted index
+    static void IndexRecord(Tables& tables, uint32_t id, const TrackTable& decoded, const TrackTable::Row& track) {
+        std::vector<std::string> tokens;
+        Tokenize(decoded.Str(track.title), tokens);
+        Tokenize(decoded.Str(track.artist), tokens);
+        Tokenize(decoded.Str(track.album), tokens);
+        std::sort(tokens.begin(), tokens.end());
+        tokens.erase(std::unique(tokens.begin(), tokens.end()), tokens.end());
+        for (const auto& token : tokens) tables.postings[token].push_back(id);
+    }
+
+    // Register a record stored at `offset`, given its decoded track
+    static void AddRecord(Tables& tables, uint32_t offset, uint32_t length,
+                          const TrackTable& decoded, const TrackTable::Row& track) {
+        uint32_t id = (uint32_t)tables.records.size();
+        Record record = { offset, length, true };
+        tables.records.push_back(record);
+        tables.liveBytes += length;
+        TrigramSignature signature;
+        signature.AddText(decoded.Str(track.title));
+        signature.AddText(decoded.Str(track.artist));
+        tables.signatures.push_back(signature);
+
+        auto existing = tables.byVideoId.find(decoded.Str(track.videoId));
+        if (existing != tables.byVideoId.end()) {
+            Record& old = tables.records[existing->second];
+            old.live = false;
+            tables.liveBytes -= old.length;
+            existing->second = id;
+        } else {
+            tables.byVideoId[decoded.Str(track.videoId)] = id;
+        }
+        IndexRecord(tables, id, decoded, track);
+    }
+
+    // Register the records in data[begin, end), decoding each one once.
+    // Returns where the last whole record ends.
+    static uint64_t AddRecords(Tables& tables, const char* data, uint64_t begin, uint64_t end) {
+        RecordReader reader(data + begin, (size_t)(end - begin));
+        TrackTable decoded;
+        size_t parsed = 0;
+        while (parsed < end - begin) {
+            decoded.Clear();
+            if (!ReadTrackRecord(reader, decoded)) break;
+            if (!decoded.Empty()) {
+                AddRecord(tables, (uint32_t)(begin + parsed), (uint32_t)(reader.Offset() - parsed), decoded, decoded[0]);
+            }
+            parsed = reader.Offset();
+        }
+        return begin + parsed;
+    }
+
+    // Rebuild the in-memory state from the mapped records
+    void Rebuild() {
+        tables = Tables();
+        uint64_t parsed = AddRecords(tables, file.Data(), HeaderSize, dataEnd);
+        // Drop a torn record at the end (e.g. a crash mid-append)
+        if (parsed < dataEnd) WriteDataEnd(parsed);
+    }
+
+    bool Append(const std::string& bytes, const TrackTable& source, const TrackTable::Row& track) {
+        if (dataEnd + bytes.size() > file.Size()) {
+            size_t newSize = file.Size() * 2;
+            while (newSize < dataEnd + bytes.size()) newSize *= 2;
+            if (!file.Open(path, newSize)) return false;
+        }
+        memcpy(file.Data() + dataEnd, bytes.data(), bytes.size());
+        uint32_t offset = (uint32_t)dataEnd;
+        WriteDataEnd(dataEnd + bytes.size());
+        AddRecord(tables, offset, (uint32_t)bytes.size(), source, track);
+        return true;
+    }
+
+    // Rewrite the file with only live records, newest first under the cap.
+    // Called with `compacting` set and the lock released: the live records
+    // are copied under the lock, the new file and tables are built without
+    // it, and records added meanwhile are carried over at the swap.
+    void Compact() {
+        std::string contents;
+        uint64_t copiedEnd;
+        size_t before;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!file.IsOpen()) {
+                compacting = false;
+                return;
+            }
+            uint64_t budget = (uint64_t)LocalIndexMaxBytes * 3 / 4;
+            std::vector<uint32_t> keep;
+            uint64_t keptBytes = 0;
+            for (uint32_t id = (uint32_t)tables.records.size(); id-- > 0;) {
+                const Record& record = tables.records[id];
+                if (!record.live) continue;
+                if (keptBytes + record.length > budget) break;
+                keep.push_back(id);
+                keptBytes += record.length;
+            }
+
+            contents.assign(file.Data(), HeaderSize);
+            contents.reserve(HeaderSize + keptBytes);
+            for (size_t i = keep.size(); i-- > 0;) {
+                const Record& record = tables.records[keep[i]];
+                contents.append(file.Data() + record.offset, record.length);
+            }
+            copiedEnd = dataEnd;
+            before = tables.records.size();
+        }
+
+        Tables compacted;
+        AddRecords(compacted, contents.data(), HeaderSize, contents.size());
+        std::string tempPath = path + ".tmp";
+        bool written;
+        {
+            std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+            written = out.is_open() && (out << contents);
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        compacting = false;
+        if (!written || !file.IsOpen()) {
+            std::remove(tempPath.c_str());
+            return;
+        }
+        // Records appended since the copy go after the compacted ones
+        std::string added(file.Data() + copiedEnd, (size_t)(dataEnd - copiedEnd));
+        uint64_t addedAt = contents.size();
+        uint64_t end = addedAt + added.size();
+        {
+            std::fstream out(tempPath, std::ios::binary | std::ios::in | std::ios::out);
+            out.seekp(0, std::ios::end);
+            out.write(added.data(), added.size());
+            out.seekp(16);
+            out.write((const char*)&end, sizeof(end));
+            if (!out) {
+                out.close();
+                std::remove(tempPath.c_str());
+                return;
+            }
+        }
+        file.Close();     // Windows cannot replace a mapped file
+        std::remove(path.c_str());
+        std::rename(tempPath.c_str(), path.c_str());
+        if (!MapFile()) return;
+        std::swap(tables, compacted);   // the old tables are freed after the lock is released
+        AddRecords(tables, file.Data(), addedAt, dataEnd);
+        Logger::Log("LocalTrackIndex: Compacted " + std::to_string(before) + " records to " +
+            std::to_string(tables.records.size()));
+    }
+
+    static std::vector<uint32_t> Intersect(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b) {
+        std::vector<uint32_t> out;
+        std::set_intersection(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(out));
+        return out;
+    }
+
+    // Ascending ids of the records that have a token starting with prefix
+    std::vector<uint32_t> PrefixMatches(const std::string& prefix) const {
+        std::vector<uint32_t> ids;
+        for (auto it = tables.postings.lower_bound(prefix);
+             it != tables.postings.end() && it->first.compare(0, prefix.size(), prefix) == 0; ++it) {
+            ids.insert(ids.end(), it->second.begin(), it->second.end());
+        }
+        std::sort(ids.begin(), ids.end());
+        ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+        return ids;
+    }
+
+public:
+    explicit LocalTrackIndex(const std::string& filePath) : path(filePath), dataEnd(0), compacting(false), ready(false) {}
+
+    // Map and load the index; takes a while for a large index, so run it off the VDJ thread
+    bool Open() {
+        auto start = std::chrono::steady_clock::now();
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!MapFile()) {
+            Logger::Error("LocalTrackIndex: Could not map " + path);
+            return false;
+        }
+        Rebuild();
+        ready = true;
+        auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+        Logger::Log("LocalTrackIndex: Loaded " + std::to_string(tables.byVideoId.size()) + " tracks (" +
+            std::to_string(tables.postings.size()) + " tokens) in " + std::to_string((long long)ms) + " ms");
+        return true;
+    }
+
+    void Close() {
+        std::lock_guard<std::mutex> lock(mutex);
+        ready = false;
+        file.Flush();
+        file.Close();
+    }
+
+    // Remember tracks; unchanged ones cost a lookup and a compare
+    void Add(const TrackTable& tracks) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!file.IsOpen()) return;
+
+            std::string bytes;
+            size_t added = 0;
+            for (const auto& track : tracks) {
+                bytes.clear();
+                WriteTrackRecord(bytes, tracks, track);
+                auto existing = tables.byVideoId.find(tracks.Str(track.videoId));
+                if (existing != tables.byVideoId.end()) {
+                    const Record& record = tables.records[existing->second];
+                    if (record.length == bytes.size() && memcmp(file.Data() + record.offset, bytes.data(), bytes.size()) == 0) {
+                        continue;
+                    }
+                }
+                if (!Append(bytes, tracks, track)) break;
+                added++;
+            }
+            if (!added) return;
+            file.Flush();
+
+            uint64_t garbage = dataEnd - HeaderSize - tables.liveBytes;
+            bool oversized = dataEnd > (uint64_t)LocalIndexMaxBytes || (garbage > tables.liveBytes && dataEnd > MinCompactBytes);
+            if (!oversized || compacting) return;
+            compacting = true;
+        }
+        Compact();
+    }
+
+    // Tracks matching every word of the query (the last one as a prefix,
+    // so results appear while typing), newest first
+    TrackTablePtr Search(const std::string& query, size_t limit) {
+        std::vector<std::string> tokens;
+        Tokenize(query.c_str(), tokens);
+        if (tokens.empty() || !ready) return TrackTablePtr();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!file.IsOpen()) return TrackTablePtr();
+
+        std::vector<uint32_t> ids;
+        for (size_t i = 0; i < tokens.size(); i++) {
+            std::vector<uint32_t> matches;
+            if (i + 1 == tokens.size()) {
+                matches = PrefixMatches(tokens[i]);
+            } else {
+                auto it = tables.postings.find(tokens[i]);
+                if (it != tables.postings.end()) matches = it->second;
+            }
+            ids = i == 0 ? std::move(matches) : Intersect(ids, matches);
+            if (ids.empty()) return TrackTablePtr();
+        }
+
+        std::shared_ptr<TrackTable> results = std::make_shared<TrackTable>();
+        for (size_t i = ids.size(); i-- > 0 && results->Size() < limit;) {
+            const Record& record = tables.records[ids[i]];
+            if (!record.live) continue;
+            RecordReader reader(file.Data() + record.offset, record.length);
+            ReadTrackRecord(reader, *results);
+        }
+        return results;
+    }
+
+    // Near-matches for a mistyped query: tracks that hold at least minPercent
+    // of the query's trigrams, most shared trigrams first (newest on ties)
+    TrackTablePtr FuzzySearch(const std::string& query, size_t limit, int minPercent) {
+        TrigramSignature wanted;
+        wanted.AddText(query.c_str());
+        int wantedBits = wanted.Count();
+        if (wantedBits < MinFuzzyTrigrams || !ready) return TrackTablePtr();
+        int minCommon = (wantedBits * minPercent + 99) / 100;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!file.IsOpen()) return TrackTablePtr();
+
+        TrigramSignature::Matches candidates;               // (shared bits, record id)
+        TrigramSignature::Scan(tables.signatures.data(), (uint32_t)tables.signatures.size(), wanted, minCommon, candidates);
+        candidates.erase(std::remove_if(candidates.begin(), candidates.end(),
+            [this](const std::pair<int, uint32_t>& c) { return !tables.records[c.second].live; }), candidates.end());
+
+        size_t best = std::min(limit, candidates.size());
+        std::partial_sort(candidates.begin(), candidates.begin() + best, candidates.end(),
+            [](const std::pair<int, uint32_t>& a, const std::pair<int, uint32_t>& b) {
+                return a.first != b.first ? a.first > b.first : a.second > b.second;
+            });
+
+        std::shared_ptr<TrackTable> results = std::make_shared<TrackTable>();
+        for (size_t i = 0; i < best; i++) {
+            const Record& record = tables.records[candidates[i].second];
+            RecordReader reader(file.Data() + record.offset, record.length);
+            ReadTrackRecord(reader, *results);
+        }
+        return results;
+    }
+
+    size_t TrackCount() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return tables.byVideoId.size();
+    }
+};
+
+//////////////////////////////////////////////////////////////////////////
+// BackendMonitor - owns the bridge process and its health state.
+// A background thread probes the bridge periodically and starts it when it
+// is down; request paths only read the current state instead of probing.
+enum BackendState {
+    BackendDown,        // not reachable (or not started yet)
+    BackendStarting,    // process launched, polling for readiness
+    BackendReady,       // last probe succeeded
+    BackendDegraded     // a probe failed after being ready; requests still allowed
+};
+
+inline const char* BackendStateName(int state) {
+    switch (state) {
+    case BackendStarting: return "starting";
+    case BackendReady: return "ready";
+    case BackendDegraded: return "degraded";
+    default: return "down";
+    }
+}
+
+class BackendMonitor {
+private:
+    enum {
+        ProbeTimeoutMs = 1000,
+        FailuresBeforeDown = 2,
+        FirstPollDelayMs = 100,
+        MaxPollDelayMs = 1000,
+        LaunchCooldownSeconds = 30
+    };
+
+    HttpClient& http;
+    std::atomic<int> state;
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable wakeCv;     // wakes the monitor thread
+    std::condition_variable stateCv;    // wakes callers waiting for readiness
+    bool stopping;
+    bool startRequested;
+    bool launchFailed;                  // last launch attempt could not start the bridge
+    std::chrono::steady_clock::time_point lastLaunch;
+    bool launchedOnce;                  // a process was launched at lastLaunch
+    HANDLE pythonProcess;
+
+    void SetState(BackendState newState) {
+        int previous = state.exchange(newState);
+        if (previous != newState) {
+            Logger::Log(std::string("BackendMonitor: ") + BackendStateName(previous) + " -> " + BackendStateName(newState));
+        }
+        stateCv.notify_all();
+    }
+
+    bool Probe() {
+        return http.IsServerAlive(ProbeTimeoutMs);
+    }
+
+    // Start the Python backend process; returns false if it could not be launched
+    bool LaunchBackend() {
+        std::string backendPath = GetBackendPath();
+        Logger::Log("BackendMonitor: Starting backend, path = " + backendPath);
+
+#ifdef VDJ_WIN
+        // Build command to start Python backend
+        std::string pythonScript = backendPath + "\\main.py";
+        Logger::Log("BackendMonitor: Python script = " + pythonScript);
+        
+        // Check if Python script exists
+        DWORD fileAttr = GetFileAttributesA(pythonScript.c_str());
+        if (fileAttr == INVALID_FILE_ATTRIBUTES) {
+            Logger::Error("Python backend not installed at: " + pythonScript);
+            return false;
+        }
+
+        // Try to start Python backend using pythonw (no console window)
+        std::string command = "cmd.exe /c cd /d \"" + backendPath + "\" && start /B pythonw main.py";
+        Logger::Log("BackendMonitor: Command = " + command);
+
+        STARTUPINFOA si = { sizeof(si) };
+        PROCESS_INFORMATION pi;
+        ZeroMemory(&si, sizeof(si));
+        si.cb = sizeof(si);
+        si.dwFlags = STARTF_USESHOWWINDOW;
+        si.wShowWindow = SW_HIDE;
+
+        if (CreateProcessA(NULL, (LPSTR)command.c_str(), NULL, NULL, FALSE,
+            CREATE_NO_WINDOW | DETACHED_PROCESS, NULL, backendPath.c_str(), &si, &pi)) {
+            if (pythonProcess) CloseHandle(pythonProcess);
+            pythonProcess = pi.hProcess;
+            CloseHandle(pi.hThread);
+            return true;
+        }
+        DWORD error = GetLastError();
+        Logger::Error("Failed to start backend process. Error code: " + std::to_string(error));
+        return false;
+#elif defined(__APPLE__) || defined(__linux__)
+        // macOS/Linux
+        std::string pythonScript = backendPath + "/main.py";
+        
+        // Check if Python script exists
+        struct stat buffer;
+        if (stat(pythonScript.c_str(), &buffer) != 0) {
+            Logger::Log("BackendMonitor: Python backend not installed at: " + pythonScript);
+            return false;
+        }
+
+        // Start Python backend in background
+        std::string command = "cd \"" + backendPath + "\" && ";
+        if (!BridgeSocketPath.empty()) command += "VDJ_BRIDGE_SOCKET=\"" + BridgeSocketPath + "\" ";
+        command += "python3 main.py &";
+        return system(command.c_str()) == 0;
+#else
+        return false;
+#endif
+    }
+
+    // Sleep on the wake condition; returns false when stopping
+    bool WaitFor(std::unique_lock<std::mutex>& lock, int ms) {
+        wakeCv.wait_for(lock, std::chrono::milliseconds(ms), [this] { return stopping || startRequested; });
+        return !stopping;
+    }
+
+    // Launch the bridge and poll it with exponential backoff until it answers
+    void StartBackend(std::unique_lock<std::mutex>& lock) {
+        startRequested = false;
+        auto now = std::chrono::steady_clock::now();
+        if (launchedOnce && now - lastLaunch < std::chrono::seconds(LaunchCooldownSeconds)) {
+            // Launched recently; the process may still be coming up, just poll
+        } else {
+            lock.unlock();
+            bool launched = LaunchBackend();
+            lock.lock();
+            if (!launched) {
+                launchFailed = true;
+                SetState(BackendDown);
+                return;
+            }
+            launchedOnce = true;
+            lastLaunch = now;
+        }
+
+        SetState(BackendStarting);
+        auto startedAt = std::chrono::steady_clock::now();
+        auto deadline = startedAt + std::chrono::milliseconds(BackendStartTimeoutMs);
+        int delayMs = FirstPollDelayMs;
+        while (!stopping) {
+            lock.unlock();
+            bool alive = Probe();
+            lock.lock();
+            if (alive) {
+                Metrics::Record(Metrics::StageBackendStart, (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - startedAt).count());
+                launchFailed = false;
+                SetState(BackendReady);
+                return;
+            }
+            if (std::chrono::steady_clock::now() >= deadline) break;
+            wakeCv.wait_for(lock, std::chrono::milliseconds(delayMs), [this] { return stopping; });
+            delayMs = delayMs * 2 > MaxPollDelayMs ? MaxPollDelayMs : delayMs * 2;
+        }
+        Logger::Log("BackendMonitor: Backend process started but server not responding");
+        launchFailed = true;
+        SetState(BackendDown);
+    }
+
+    void ThreadLoop() {
+        std::unique_lock<std::mutex> lock(mutex);
+        int failures = 0;
+        while (!stopping) {
+            int current = state;
+            if (current == BackendDown) {
+                if (startRequested) {
+                    StartBackend(lock);
+                    failures = 0;
+                    continue;
+                }
+                // Nobody needs the bridge right now; check occasionally in case it was started externally
+                lock.unlock();
+                bool alive = Probe();
+                lock.lock();
+                if (alive) {
+                    launchFailed = false;
+                    SetState(BackendReady);
+                    continue;
+                }
+                if (!WaitFor(lock, HealthProbeIntervalMs)) break;
+                continue;
+            }
+
+            if (!WaitFor(lock, HealthProbeIntervalMs)) break;
+            startRequested = false;
+            lock.unlock();
+            bool alive = Probe();
+            lock.lock();
+            if (alive) {
+                failures = 0;
+                SetState(BackendReady);
+            } else if (++failures >= FailuresBeforeDown) {
+                SetState(BackendDown);
+            } else {
+                SetState(BackendDegraded);
+            }
+        }
+    }
+
+public:
+    explicit BackendMonitor(HttpClient& client)
+        : http(client), state(BackendDown), stopping(false), startRequested(false),
+          launchFailed(false), launchedOnce(false), pythonProcess(NULL) {}
+
+    ~BackendMonitor() {
+        Stop();
+    }
+
+    // Probe once and start the monitor thread
+    void Start() {
+        if (thread.joinable()) return;
+        if (Probe()) SetState(BackendReady);
+        thread = std::thread(&BackendMonitor::ThreadLoop, this);
+    }
+
+    void Stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wakeCv.notify_all();
+        stateCv.notify_all();
+        if (thread.joinable()) thread.join();
+#ifdef VDJ_WIN
+        if (pythonProcess) {
+            TerminateProcess(pythonProcess, 0);
+            CloseHandle(pythonProcess);
+            pythonProcess = NULL;
+        }
+#endif
+    }
+
+    BackendState State() const {
+        return (BackendState)state.load();
+    }
+
+    bool IsUsable() const {
+        int current = state;
+        return current == BackendReady || current == BackendDegraded;
+    }
+
+    // Fast path is a single atomic read. Otherwise ask the monitor thread to
+    // start the bridge and wait until it is ready or the attempt fails.
+    bool WaitUntilReady(int timeoutMs) {
+        if (IsUsable()) return true;
+
+        std::unique_lock<std::mutex> lock(mutex);
+        if (stopping) return false;
+        if (state == BackendDown) {
+            startRequested = true;
+            launchFailed = false;
+            wakeCv.notify_all();
+        }
+        stateCv.wait_for(lock, std::chrono::milliseconds(timeoutMs), [this] {
+            return stopping || IsUsable() || (state == BackendDown && !startRequested && launchFailed);
+        });
+        return IsUsable();
+    }
+};
+
+//////////////////////////////////////////////////////////////////////////
+// Main plugin class
+class YouTubeMusicPlugin : public IVdjPluginOnlineSource {
+private:
+    friend struct PluginBench;      // bench/ times the response parsers directly
+    HttpClient httpClient;
+    StreamUrlCache streamCache;
+    StreamUrlBatcher urlBatcher;
+    LocalTrackIndex localIndex;
+    AudioCache audioCache;
+    LoopbackProxy proxy;
+    ThumbnailCache thumbnails;
+    StreamUrlPrefetcher prefetcher;
+    NextTrackPrefetcher nextTracks;
+    SearchCache searchCache;
+    PlaylistTrackCache playlistCache;
+    PlaylistStore playlistStore;
+    FeedbackOverlay feedback;
+    TrackTablePtr searchResults;
+    std::vector<Playlist> userPlaylists;
+    TrackTablePtr currentPlaylistTracks;
+    HttpValidators playlistsValidators;     // of the response userPlaylists was parsed from
+    std::string currentFolder;              // last folder VDJ asked for in GetFolder
+    BackendMonitor backend;
+    std::mutex dataMutex;
+    bool authPromptShown = false;
+    std::atomic<bool> playlistDeltaSupported{true};     // cleared on the first 404 from /playlist_delta
+    std::atomic<bool> playlistsRefreshing{false};       // a background RefreshPlaylists is queued or running
+    std::mutex searchMutex;
+    CancelTokenPtr activeSearch;    // token of the newest OnSearch, cancelled when superseded
+    // Declared last so it is constructed after, and shut down before, the
+    // components whose tasks it runs
+    WorkerPool workers;
+    WorkerPool warmup;      // playlist warm-up, one playlist per thread
+
+    void OpenConfigPageIfNeeded() {
+    if (authPromptShown) return;
 
     // Only trigger once per session
     authPromptShown = true;
-    std::string url = "http://127.0.0.1:8000/config";
+    std::string url = httpClient.BaseUrl() + "/config";
     Logger::Log("Opening config page: " + url);
 
-#ifdef VDJ_WIN
-    ShellExecuteA(NULL, "open", url.c_str(), NULL, NULL, SW_SHOWNORMAL);
-#elif defined(__APPLE__)
-    std::string cmd = "open '" + url + "'";
-    system(cmd.c_str());
-#else
-    std::string cmd = "xdg-open '" + url + "'";
-    system(cmd.c_str());
-#endif
+#ifdef VDJ_WIN
+    ShellExecuteA(NULL, "open", url.c_str(), NULL, NULL, SW_SHOWNORMAL);
+#elif defined(__APPLE__)
+    std::string cmd = "open '" + url + "'";
+    system(cmd.c_str());
+#else
+    std::string cmd = "xdg-open '" + url + "'";
+    system(cmd.c_str());
+#endif
+    }
+
+    // URL encoding helper
+    std::string UrlEncode(const std::string& value) {
+        std::ostringstream escaped;
+        escaped.fill('0');
+        escaped << std::hex;
+
+        for (char c : value) {
+            if (isalnum(c) || c == '-' || c == '_' || c == '.' || c == '~') {
+                escaped << c;
+            } else if (c == ' ') {
+                escaped << '+';
+            } else {
+                escaped << '%' << std::setw(2) << std::hex << std::uppercase << int((unsigned char)c);
+            }
+        }
+
+        return escaped.str();
+    }
+
+    // Wait for the bridge if the health monitor does not report it usable
+    bool EnsureBackendRunning() {
+        if (backend.IsUsable()) return true;
+
+        Logger::Log(std::string("EnsureBackendRunning: Backend is ") + BackendStateName(backend.State()) + ", waiting...");
+        bool ready = backend.WaitUntilReady(BackendStartTimeoutMs);
+        Logger::Log(std::string("EnsureBackendRunning: Backend is ") + BackendStateName(backend.State()));
+        return ready;
+    }
+
+    // URL handed to VDJ for a resolved stream: the loopback proxy, which
+    // starts serving as soon as the first chunk is on disk, or else the
+    // remote URL with a background download into the audio cache. A fill
+    // that fails or shows nothing within ProxyStartTimeoutMs (expired URL,
+    // 403/416, network error) would leave the deck on a dead proxy
+    // response, so VDJ gets the remote URL then.
+    std::string PlaybackUrl(const std::string& videoId, const std::string& streamUrl) {
+        if (proxy.IsRunning() && audioCache.Stream(videoId, streamUrl)) {
+            PartialTrackPtr track = audioCache.OpenStream(videoId);
+            if (track && track->WaitForSize(ProxyStartTimeoutMs) >= 0) {
+                return proxy.UrlFor(videoId, GuessAudioExtension(streamUrl));
+            }
+            Logger::Error("PlaybackUrl: Proxy fill for " + videoId + " did not start, using the remote URL");
+            return streamUrl;
+        }
+        audioCache.Enqueue(videoId, streamUrl, false);
+        return streamUrl;
+    }
+
+    // Check authentication and open config page if not authenticated
+    void EnsureAuthUI() {
+        bool auth = httpClient.IsAuthenticated();
+        if (!auth) {
+            Logger::Log("Auth not configured, launching config page...");
+            OpenConfigPageIfNeeded();
+        }
+    }
+
+    // Make `token` the active search, cancelling the one it supersedes
+    void BeginSearch(const CancelTokenPtr& token) {
+        CancelTokenPtr previous;
+        {
+            std::lock_guard<std::mutex> lock(searchMutex);
+            previous = activeSearch;
+            activeSearch = token;
+        }
+        if (previous) {
+            Logger::Log("OnSearch: Cancelling superseded search");
+            previous->Cancel();
+        }
+    }
+
+    void EndSearch(const CancelTokenPtr& token) {
+        std::lock_guard<std::mutex> lock(searchMutex);
+        if (activeSearch == token) activeSearch.reset();
+    }
+
+    // Wait out the debounce window; returns false if the search was superseded meanwhile
+    bool DebounceSearch(const CancelTokenPtr& token) {
+        const int stepMs = 10;
+        for (int waited = 0; waited < SearchDebounceMs; waited += stepMs) {
+            if (token->IsCancelled()) return false;
+            std::this_thread::sleep_for(std::chrono::milliseconds(stepMs));
+        }
+        return !token->IsCancelled();
+    }
+
+    void AddTracks(IVdjTracksList* tracksList, const TrackTable& tracks) {
+        MetricTimer timer(Metrics::StageTracksAdd);
+        for (const auto& track : tracks) {
+            std::string cover = thumbnails.CoverFor(tracks.Str(track.thumbnail));
+            tracksList->add(
+                tracks.Str(track.videoId),
+                tracks.Str(track.title),
+                tracks.Str(track.artist),
+                nullptr, nullptr, nullptr,
+                tracks.Str(track.album),
+                cover.c_str(),
+                nullptr,
+                track.duration,
+                0.0f, 0, 0,
+                track.isVideo,
+                false
+            );
+        }
+        thumbnails.Prefetch(tracks);
+    }
+
+    // Remember the open playlist and keep its stream URLs fresh in the background
+    void SetOpenPlaylist(const TrackTablePtr& tracks) {
+        std::vector<std::string> playlistIds;
+        playlistIds.reserve(tracks->Size());
+        for (const auto& track : *tracks) playlistIds.push_back(tracks->Str(track.videoId));
+        streamCache.SetPlaylistIds(playlistIds);
+        nextTracks.SetPlaylist(tracks);
+
+        std::lock_guard<std::mutex> lock(dataMutex);
+        currentPlaylistTracks = tracks;
     }
 
-    // URL encoding helper
-    std::string UrlEncode(const std::string& value) {
-        std::ostringstream escaped;
-        escaped.fill('0');
-        escaped << std::hex;
+    bool IsOpenFolder(const std::string& folderId) {
+        std::lock_guard<std::mutex> lock(dataMutex);
+        return currentFolder == folderId;
+    }
 
-        for (char c : value) {
-            if (isalnum(c) || c == '-' || c == '_' || c == '.' || c == '~') {
-                escaped << c;
-            } else if (c == ' ') {
-                escaped << '+';
+    // Add freshly parsed tracks to the local index (off the calling thread)
+    void RememberTracks(const TrackTablePtr& tracks) {
+        if (!LocalIndexEnabled || !tracks || tracks->Empty()) return;
+        workers.Submit([this, tracks] { localIndex.Add(*tracks); });
+    }
+
+    // The first `count` tracks of a table
+    static TrackTablePtr TruncateTracks(const TrackTablePtr& tracks, size_t count) {
+        std::shared_ptr<TrackTable> head = std::make_shared<TrackTable>();
+        for (size_t i = 0; i < count && i < tracks->Size(); i++) head->AppendRow(*tracks, (*tracks)[i]);
+        return head;
+    }
+
+    // Remote results first, then the local matches the bridge did not return
+    static TrackTablePtr MergeTracks(const TrackTablePtr& remote, const TrackTablePtr& local) {
+        if (!local || local->Empty() || remote == local) return remote;
+        std::unordered_set<std::string> seen;
+        for (const auto& track : *remote) seen.insert(remote->Str(track.videoId));
+
+        std::shared_ptr<TrackTable> merged;
+        for (const auto& track : *local) {
+            if (seen.count(local->Str(track.videoId))) continue;
+            if (!merged) merged = std::make_shared<TrackTable>(*remote);
+            merged->AppendRow(*local, track);
+        }
+        if (!merged) return remote;
+        return merged;
+    }
+
+    // Resolve stream URLs for the top of an opened playlist in batches
+    void ResolvePlaylistHead(const TrackTable& tracks) {
+        std::vector<std::string> ids;
+        for (const auto& track : tracks) {
+            if ((int)ids.size() >= PlaylistResolveCount) break;
+            ids.push_back(tracks.Str(track.videoId));
+        }
+        if (!ids.empty()) urlBatcher.Enqueue(ids);
+    }
+
+    enum PageResult { PageFailed, PageFetched, PageUnchanged };
+
+    // Fetch one page of a playlist. total is -1 if the bridge returned the whole list.
+    // With `known` validators the request is conditional; PageUnchanged means the
+    // cached data is still current (304, or an identical body) and nothing was parsed.
+    PageResult FetchPlaylistPage(const std::string& playlistId, int offset, bool background,
+                                 TrackTable& tracks, int& total,
+                                 const HttpValidators* known = nullptr, HttpValidators* received = nullptr) {
+        std::string endpoint = "/playlist_tracks?id=" + playlistId +
+            "&offset=" + std::to_string(offset) + "&limit=" + std::to_string(PlaylistPageSize);
+        HttpRequestOptions options;
+        options.background = background;
+        options.compact = true;
+        if (known) known->Apply(options);
+        HttpResponse response = httpClient.Request(endpoint, options);
+        Metrics::Count(Metrics::PlaylistFullBytes, response.body.size());
+        if (known && (response.NotModified() || known->SameBody(response))) return PageUnchanged;
+        if (response.body.empty()) return PageFailed;
+        if (received) *received = HttpValidators::From(response);
+        return ParseTrackPage(response.body, tracks, total) ? PageFetched : PageFailed;
+    }
+
+    // Fetch pages [firstPage, pages.size()) with up to PlaylistPageParallelism requests in flight
+    bool FetchPlaylistPages(const std::string& playlistId, size_t firstPage, bool background,
+                            std::vector<TrackTable>& pages) {
+        std::atomic<size_t> nextPage(firstPage);
+        std::atomic<bool> failed(false);
+        auto fetchLoop = [&] {
+            for (size_t page; (page = nextPage++) < pages.size() && !failed;) {
+                int total;
+                if (FetchPlaylistPage(playlistId, (int)page * PlaylistPageSize, background, pages[page], total) != PageFetched) {
+                    failed = true;
+                }
+            }
+        };
+
+        size_t remaining = pages.size() > firstPage ? pages.size() - firstPage : 0;
+        size_t threadCount = PlaylistPageParallelism > 1 ? (size_t)PlaylistPageParallelism : 1;
+        if (threadCount > remaining) threadCount = remaining;
+        std::vector<std::thread> threads;
+        for (size_t i = 1; i < threadCount; i++) threads.emplace_back(fetchLoop);
+        fetchLoop();
+        for (auto& t : threads) t.join();
+        return !failed;
+    }
+
+    static TrackTablePtr JoinPages(std::vector<TrackTable>& pages) {
+        if (pages.size() == 1) {
+            pages[0].ShrinkToFit();
+            return std::make_shared<const TrackTable>(std::move(pages[0]));
+        }
+        size_t arenaBytes = 0;
+        size_t count = 0;
+        for (const auto& page : pages) {
+            arenaBytes += page.ArenaSize();
+            count += page.Size();
+        }
+        std::shared_ptr<TrackTable> tracks = std::make_shared<TrackTable>();
+        tracks->Reserve(arenaBytes, count);
+        for (const auto& page : pages) tracks->Append(page);
+        return tracks;
+    }
+
+    // Changes to a playlist since a snapshot, as sent by /playlist_delta.
+    // Ops apply in order to the list as it stands after the previous op;
+    // each insert takes the next track of `inserted`.
+    struct PlaylistDelta {
+        enum OpKind { Insert, Remove, Move };
+        struct Op {
+            OpKind kind;
+            int from;       // Remove, Move
+            int to;         // Insert, Move
+        };
+
+        std::string snapshot;
+        int total;
+        TrackTable inserted;
+        std::vector<Op> ops;
+
+        PlaylistDelta() : total(-1) {}
+    };
+
+    // Parse { "snapshot": S, "total": N, "tracks": [...], "ops": [{ "op": "insert", "index": I }, ...] }.
+    // False if malformed or there is no "ops" array.
+    static bool ParsePlaylistDelta(const std::string& json, PlaylistDelta& delta) {
+        MetricTimer timer(Metrics::StageParse);
+        JsonReader reader(json);
+        JsonReader::Token t = reader.Next();
+        if (t != JsonReader::BeginObject) return false;
+
+        bool sawOps = false;
+        while ((t = reader.Next()) == JsonReader::Key) {
+            bool isSnapshot = reader.KeyIs("snapshot");
+            bool isTotal = reader.KeyIs("total");
+            bool isTracks = reader.KeyIs("tracks");
+            bool isOps = reader.KeyIs("ops");
+            JsonReader::Token v = reader.Next();
+            if (isSnapshot && v == JsonReader::String) {
+                reader.ReadString(delta.snapshot);
+            } else if (isTotal) {
+                delta.total = reader.AsInt(v);
+            } else if (isTracks && v == JsonReader::BeginArray) {
+                ParseTrackArray(reader, delta.inserted);
+                continue;
+            } else if (isOps && v == JsonReader::BeginArray) {
+                while ((v = reader.Next()) == JsonReader::BeginObject) {
+                    PlaylistDelta::Op op = { PlaylistDelta::Insert, -1, -1 };
+                    bool known = false;
+                    while ((t = reader.Next()) == JsonReader::Key) {
+                        bool isOp = reader.KeyIs("op");
+                        bool isIndex = reader.KeyIs("index");
+                        bool isFrom = reader.KeyIs("from");
+                        bool isTo = reader.KeyIs("to");
+                        JsonReader::Token field = reader.Next();
+                        if (isOp && field == JsonReader::String) {
+                            known = true;
+                            if (reader.StringIs("insert", 6)) op.kind = PlaylistDelta::Insert;
+                            else if (reader.StringIs("remove", 6)) op.kind = PlaylistDelta::Remove;
+                            else if (reader.StringIs("move", 4)) op.kind = PlaylistDelta::Move;
+                            else known = false;
+                        } else if (isIndex) {
+                            op.from = op.to = reader.AsInt(field);
+                        } else if (isFrom) {
+                            op.from = reader.AsInt(field);
+                        } else if (isTo) {
+                            op.to = reader.AsInt(field);
+                        }
+                        if (!reader.Skip(field)) return false;
+                    }
+                    if (t != JsonReader::EndObject || !known) return false;
+                    delta.ops.push_back(op);
+                }
+                if (v != JsonReader::EndArray) return false;
+                sawOps = true;
+                continue;
+            }
+            if (!reader.Skip(v)) return false;
+        }
+        return t == JsonReader::EndObject && sawOps;
+    }
+
+    // The playlist after applying a delta to base, or nullptr if an op is
+    // out of range or the result does not have the announced length
+    static TrackTablePtr ApplyPlaylistDelta(const TrackTable& base, const PlaylistDelta& delta) {
+        // Rows below base.Size() are base rows, the rest inserted ones
+        std::vector<size_t> order(base.Size());
+        for (size_t i = 0; i < order.size(); i++) order[i] = i;
+        size_t nextInserted = 0;
+        for (const auto& op : delta.ops) {
+            size_t row;
+            if (op.kind == PlaylistDelta::Insert) {
+                if (nextInserted >= delta.inserted.Size()) return nullptr;
+                row = base.Size() + nextInserted++;
             } else {
-                escaped << '%' << std::setw(2) << std::hex << std::uppercase << int((unsigned char)c);
+                if (op.from < 0 || (size_t)op.from >= order.size()) return nullptr;
+                row = order[op.from];
+                order.erase(order.begin() + op.from);
+                if (op.kind == PlaylistDelta::Remove) continue;
             }
+            if (op.to < 0 || (size_t)op.to > order.size()) return nullptr;
+            order.insert(order.begin() + op.to, row);
         }
+        if (delta.total >= 0 && order.size() != (size_t)delta.total) return nullptr;
 
-        return escaped.str();
+        std::shared_ptr<TrackTable> tracks = std::make_shared<TrackTable>();
+        tracks->Reserve(base.ArenaSize() + delta.inserted.ArenaSize(), order.size());
+        for (size_t row : order) {
+            if (row < base.Size()) tracks->AppendRow(base, base[row]);
+            else tracks->AppendRow(delta.inserted, delta.inserted[row - base.Size()]);
+        }
+        tracks->ShrinkToFit();
+        return tracks;
     }
 
-    // Start Python backend if not running
-    bool EnsureBackendRunning() {
-        Logger::Log("EnsureBackendRunning: Checking backend status...");
-        
-        if (backendRunning && httpClient.IsServerAlive()) {
-            Logger::Log("EnsureBackendRunning: Backend already running");
-            return true;
+    enum DeltaResult { DeltaFailed, DeltaApplied, DeltaUnchanged };
+
+    // Ask the bridge what changed in a playlist since `snapshot` (the ETag
+    // it was loaded at). DeltaApplied fills tracks and the new snapshot.
+    // DeltaFailed means only a full load can help: the bridge has no
+    // /playlist_delta, no longer knows the snapshot (409), or the delta
+    // does not fit the tracks we hold.
+    DeltaResult FetchPlaylistDelta(const std::string& playlistId, const TrackTable& base, bool background,
+                                   TrackTablePtr& tracks, std::string& snapshot) {
+        if (!playlistDeltaSupported || snapshot.empty()) return DeltaFailed;
+        HttpRequestOptions options;
+        options.background = background;
+        HttpResponse response = httpClient.Request("/playlist_delta?id=" + playlistId + "&since=" + UrlEncode(snapshot), options);
+        if (response.status == 404 || response.status == 405) {
+            playlistDeltaSupported = false;
+            Logger::Log("GetFolder: Bridge has no /playlist_delta, playlists are loaded in full");
+            return DeltaFailed;
+        }
+        Metrics::Count(Metrics::PlaylistDeltaBytes, response.body.size());
+        if (response.NotModified()) return DeltaUnchanged;
+        if (response.status != 200 || response.body.empty()) {
+            if (response.status == 409) {
+                Metrics::Count(Metrics::PlaylistResyncs);
+                Logger::Log("GetFolder: Snapshot of playlist " + playlistId + " is unknown to the bridge, resyncing");
+            }
+            return DeltaFailed;
         }
 
-        Logger::Log("EnsureBackendRunning: Backend not running, attempting to start...");
-        std::string backendPath = GetBackendPath();
-        Logger::Log("EnsureBackendRunning: Backend path = " + backendPath);
+        PlaylistDelta delta;
+        if (!ParsePlaylistDelta(response.body, delta)) {
+            playlistDeltaSupported = false;
+            Logger::Error("GetFolder: /playlist_delta did not answer with a delta, playlists are loaded in full");
+            return DeltaFailed;
+        }
+        std::string current = response.etag.empty() ? delta.snapshot : response.etag;
+        if (delta.ops.empty() && (current.empty() || current == snapshot)) return DeltaUnchanged;
+        TrackTablePtr applied = ApplyPlaylistDelta(base, delta);
+        if (!applied || current.empty()) {
+            Metrics::Count(Metrics::PlaylistResyncs);
+            Logger::Log("GetFolder: Delta for playlist " + playlistId + " does not apply, resyncing");
+            return DeltaFailed;
+        }
+        Logger::Log("GetFolder: Playlist " + playlistId + " updated with " + std::to_string(delta.ops.size()) +
+            " changes (" + std::to_string(response.body.size()) + " bytes)");
+        tracks = applied;
+        snapshot = current;
+        return DeltaApplied;
+    }
 
-#ifdef VDJ_WIN
-        // Build command to start Python backend
-        std::string pythonScript = backendPath + "\\main.py";
-        Logger::Log("EnsureBackendRunning: Python script = " + pythonScript);
-        
-        // Check if Python script exists
-        DWORD fileAttr = GetFileAttributesA(pythonScript.c_str());
-        if (fileAttr == INVALID_FILE_ATTRIBUTES) {
-            Logger::Error("Python backend not installed at: " + pythonScript);
+    // Bring a complete cached playlist up to date through /playlist_delta and
+    // put the result in the PlaylistTrackCache (and the store). False if a
+    // full load is needed.
+    bool SyncPlaylist(const std::string& playlistId, const PlaylistTrackCache::Snapshot& cached, bool background,
+                      TrackTablePtr& tracks) {
+        std::string snapshot = cached.validators.etag;
+        switch (FetchPlaylistDelta(playlistId, *cached.tracks, background, tracks, snapshot)) {
+        case DeltaUnchanged:
+            playlistCache.Touch(playlistId);
+            tracks = cached.tracks;
+            return true;
+        case DeltaApplied: {
+            HttpValidators validators;
+            validators.etag = snapshot;
+            playlistCache.Put(playlistId, tracks, true, validators);
+            StorePlaylist(playlistId, tracks, snapshot);
+            RememberTracks(tracks);
+            return true;
+        }
+        default:
             return false;
         }
-        
-        Logger::Log("EnsureBackendRunning: Python script found, starting backend...");
+    }
 
-        // Try to start Python backend using pythonw (no console window)
-        std::string command = "cmd.exe /c cd /d \"" + backendPath + "\" && start /B pythonw main.py";
-        Logger::Log("EnsureBackendRunning: Command = " + command);
+    // Put the stored copy of a playlist in the PlaylistTrackCache; false if none
+    bool LoadStoredPlaylist(const std::string& playlistId, PlaylistTrackCache::Snapshot& cached) {
+        if (!PlaylistStoreEnabled) return false;
+        TrackTablePtr tracks;
+        std::string snapshot;
+        if (!playlistStore.Load(playlistId, tracks, snapshot)) return false;
+        cached.tracks = tracks;
+        cached.complete = true;
+        cached.loading = false;
+        cached.validators = HttpValidators();
+        cached.validators.etag = snapshot;
+        playlistCache.Put(playlistId, tracks, true, cached.validators);
+        Logger::Log("GetFolder: Playlist " + playlistId + " read from disk (" + std::to_string(tracks->Size()) + " tracks)");
+        return true;
+    }
 
-        STARTUPINFOA si = { sizeof(si) };
-        PROCESS_INFORMATION pi;
-        ZeroMemory(&si, sizeof(si));
-        si.cb = sizeof(si);
-        si.dwFlags = STARTF_USESHOWWINDOW;
-        si.wShowWindow = SW_HIDE;
+    // Persist a complete playlist with its snapshot (off the calling thread)
+    void StorePlaylist(const std::string& playlistId, const TrackTablePtr& tracks, const std::string& snapshot) {
+        if (!PlaylistStoreEnabled || snapshot.empty()) return;
+        workers.Submit([this, playlistId, tracks, snapshot] { playlistStore.Save(playlistId, *tracks, snapshot); });
+    }
 
-        if (CreateProcessA(NULL, (LPSTR)command.c_str(), NULL, NULL, FALSE,
-            CREATE_NO_WINDOW | DETACHED_PROCESS, NULL, backendPath.c_str(), &si, &pi)) {
-            pythonProcess = pi.hProcess;
-            CloseHandle(pi.hThread);
-            
-            Logger::Log("EnsureBackendRunning: Process started, waiting 4 seconds...");
+    // Update userPlaylists from /playlists (conditional on what we already parsed)
+    bool RefreshPlaylists(bool background) {
+        HttpRequestOptions options;
+        options.background = background;
+        options.compact = true;
+        HttpValidators known;
+        {
+            std::lock_guard<std::mutex> lock(dataMutex);
+            if (!userPlaylists.empty()) known = playlistsValidators;
+        }
+        known.Apply(options);
+        HttpResponse response = httpClient.Request("/playlists", options);
+        if (response.NotModified()) {
+            Logger::Log("RefreshPlaylists: Not modified, reusing parsed list");
+            return true;
+        }
+        if (response.body.empty()) {
+            return false;
+        }
 
-            // Wait for server to start
-            Sleep(4000);
+        std::lock_guard<std::mutex> lock(dataMutex);
+        if (userPlaylists.empty() || !known.SameBody(response)) {
+            userPlaylists = ParsePlaylists(response.body);
+            if (PlaylistStoreEnabled) {
+                std::vector<Playlist> playlists = userPlaylists;
+                workers.Submit([this, playlists] { playlistStore.SaveList(playlists); });
+            }
+        }
+        playlistsValidators = HttpValidators::From(response);
+        return true;
+    }
 
-            backendRunning = httpClient.IsServerAlive();
-            if (backendRunning) {
-                Logger::Log("EnsureBackendRunning: Backend started successfully!");
-            } else {
-                Logger::Error("Backend process started but server not responding");
+    // RefreshPlaylists on the warm-up pool, once at a time; skipped while
+    // the bridge is down (OnLoad refreshes the list once it is up)
+    void RefreshPlaylistsInBackground() {
+        if (!backend.IsUsable() || playlistsRefreshing.exchange(true)) return;
+        warmup.Submit([this] {
+            RefreshPlaylists(true);
+            playlistsRefreshing = false;
+        });
+    }
+
+    // Load every playlist into the PlaylistTrackCache at low priority, so
+    // opening one later is served from memory (runs on the warm-up pool)
+    void WarmUpPlaylists() {
+        if (!RefreshPlaylists(true)) return;
+        std::vector<std::string> playlistIds;
+        {
+            std::lock_guard<std::mutex> lock(dataMutex);
+            for (const auto& playlist : userPlaylists) {
+                if (!playlist.playlistId.empty()) playlistIds.push_back(playlist.playlistId);
             }
-            return backendRunning;
-        } else {
-            DWORD error = GetLastError();
-            Logger::Error("Failed to start backend process. Error code: " + std::to_string(error));
         }
-#elif defined(__APPLE__) || defined(__linux__)
-        // macOS/Linux
-        std::string pythonScript = backendPath + "/main.py";
-        
-        // Check if Python script exists
-        struct stat buffer;
-        if (stat(pythonScript.c_str(), &buffer) != 0) {
-            return false;
+        Logger::Log("Warm-up: Loading " + std::to_string(playlistIds.size()) + " playlists in the background");
+        for (const auto& playlistId : playlistIds) {
+            warmup.Submit([this, playlistId] { WarmPlaylist(playlistId); });
         }
+    }
 
-        // Start Python backend in background
-        std::string command = "cd \"" + backendPath + "\" && python3 main.py &";
-        int result = system(command.c_str());
-        
-        if (result == 0) {
-            sleep(4);
-            backendRunning = httpClient.IsServerAlive();
-            return backendRunning;
+    // Load one whole playlist unless it is cached or already loading. A
+    // stored copy is updated with a delta; otherwise pages are fetched one
+    // after another (parallelism comes from the pool).
+    void WarmPlaylist(const std::string& playlistId) {
+        PlaylistTrackCache::Snapshot cached;
+        if (playlistCache.Get(playlistId, cached) && (cached.complete || cached.loading)) return;
+        if (!playlistCache.TryBeginLoad(playlistId)) return;
+
+        TrackTablePtr synced;
+        if (LoadStoredPlaylist(playlistId, cached) && SyncPlaylist(playlistId, cached, true, synced)) {
+            playlistCache.EndLoad(playlistId);
+            return;
         }
-#endif
-        return false;
+
+        std::vector<TrackTable> pages(1);
+        int total = -1;
+        HttpValidators validators;
+        bool ok = FetchPlaylistPage(playlistId, 0, true, pages[0], total, nullptr, &validators) == PageFetched;
+        if (ok && total > (int)pages[0].Size() && PlaylistPageSize > 0) {
+            pages.resize(((size_t)total + PlaylistPageSize - 1) / PlaylistPageSize);
+            for (size_t page = 1; page < pages.size() && ok; page++) {
+                ok = FetchPlaylistPage(playlistId, (int)page * PlaylistPageSize, true, pages[page], total) == PageFetched;
+            }
+        }
+        if (ok) {
+            TrackTablePtr tracks = JoinPages(pages);
+            playlistCache.Put(playlistId, tracks, true, validators);
+            StorePlaylist(playlistId, tracks, validators.etag);
+            RememberTracks(tracks);
+            Logger::Log("Warm-up: Playlist " + playlistId + " loaded (" + std::to_string(tracks->Size()) + " tracks)");
+        }
+        playlistCache.EndLoad(playlistId);
     }
 
-    // Check authentication and open config page if not authenticated
-    void EnsureAuthUI() {
-        bool auth = httpClient.IsAuthenticated();
-        if (!auth) {
-            Logger::Log("Auth not configured, launching config page...");
-            OpenConfigPageIfNeeded();
+    // Background part of a progressive playlist load (runs on the worker pool)
+    void CompletePlaylistLoad(const std::string& playlistId, const TrackTablePtr& firstPage, size_t pageCount,
+                              const HttpValidators& validators) {
+        std::vector<TrackTable> pages(pageCount);
+        pages[0] = *firstPage;
+        bool ok = FetchPlaylistPages(playlistId, 1, true, pages);
+        TrackTablePtr tracks = JoinPages(pages);
+        Logger::Log("GetFolder: Playlist " + playlistId + " loaded in background (" +
+            std::to_string(tracks->Size()) + " tracks" + (ok ? ")" : ", incomplete)"));
+        // The DJ may have opened another folder while the pages were loading
+        if (ok && IsOpenFolder(playlistId)) SetOpenPlaylist(tracks);
+        playlistCache.Put(playlistId, tracks, ok, validators);
+        if (ok) StorePlaylist(playlistId, tracks, validators.etag);
+        RememberTracks(tracks);
+        playlistCache.EndLoad(playlistId);
+    }
+
+    // Background refresh of a cached search (runs on the worker pool)
+    void RevalidateSearch(const std::string& cacheKey, const std::string& endpoint) {
+        HttpRequestOptions options;
+        options.background = true;
+        options.compact = true;
+        std::string response = httpClient.Get(endpoint, options);
+        if (response.empty()) {
+            searchCache.RevalidationFailed(cacheKey);
+            return;
         }
+        TrackTablePtr tracks = ParseTracks(response);
+        searchCache.Put(cacheKey, tracks);
+        RememberTracks(tracks);
+        Logger::Log("OnSearch: Revalidated cached search '" + cacheKey + "'");
+    }
+
+    // Reserve a table for the tracks of a response: the arena can never
+    // need more than the JSON itself, rows are estimated generously
+    static void ReserveForResponse(TrackTable& tracks, const std::string& json) {
+        tracks.Reserve(json.size() + 1, json.size() / 256 + 16);
     }
 
-    // Parse tracks from JSON array
-    std::vector<Track> ParseTracks(const std::string& json) {
-        std::vector<Track> tracks;
-        std::vector<std::string> items = SimpleJSON::ExtractArray(json);
+    // Parse track objects up to the end of the array the reader is positioned in.
+    // Strings are decoded straight into the table's arena.
+    static void ParseTrackArray(JsonReader& reader, TrackTable& tracks) {
+        for (;;) {
+            JsonReader::Token t = reader.Next();
+            if (t != JsonReader::BeginObject) {
+                if (t == JsonReader::EndArray || !reader.Skip(t)) break;
+                continue;
+            }
+
+            size_t rowStart = tracks.ArenaSize();
+            TrackTable::Row track = TrackTable::Row();
+
+            while ((t = reader.Next()) == JsonReader::Key) {
+                uint32_t* field = nullptr;
+                int kind = 0; // 0 = string, 1 = duration, 2 = isVideo
+                if (reader.KeyIs("videoId")) field = &track.videoId;
+                else if (reader.KeyIs("title")) field = &track.title;
+                else if (reader.KeyIs("artist")) field = &track.artist;
+                else if (reader.KeyIs("album")) field = &track.album;
+                else if (reader.KeyIs("thumbnail")) field = &track.thumbnail;
+                else if (reader.KeyIs("duration")) kind = 1;
+                else if (reader.KeyIs("isVideo")) kind = 2;
+                else kind = -1;
 
-        for (const auto& item : items) {
-            Track track;
-            track.videoId = SimpleJSON::ExtractString(item, "videoId");
-            track.title = SimpleJSON::ExtractString(item, "title");
-            track.artist = SimpleJSON::ExtractString(item, "artist");
-            track.album = SimpleJSON::ExtractString(item, "album");
-            track.duration = (float)SimpleJSON::ExtractInt(item, "duration");
-            track.thumbnail = SimpleJSON::ExtractString(item, "thumbnail");
-            track.isVideo = SimpleJSON::ExtractBool(item, "isVideo");
+                JsonReader::Token v = reader.Next();
+                if (kind == 0 && v == JsonReader::String) {
+                    size_t start = tracks.ArenaSize();
+                    reader.AppendString(tracks.Arena());
+                    *field = tracks.EndString(start);
+                }
+                else if (kind == 1) track.duration = (float)reader.AsInt(v);
+                else if (kind == 2) track.isVideo = reader.AsBool(v);
+                if (!reader.Skip(v)) return;
+            }
+            if (t != JsonReader::EndObject) break;
 
-            if (!track.videoId.empty() && !track.title.empty()) {
-                tracks.push_back(track);
+            if (track.videoId && track.title) {
+                tracks.AddRow(track);
+            } else {
+                tracks.TruncateArena(rowStart);
             }
         }
+    }
+
+    // Decode a binary track record body (see RecordReader); false if malformed.
+    // The arena never needs more than the body: each length prefix outweighs a NUL.
+    static bool DecodeTrackRecords(const std::string& body, TrackTable& tracks, int& total) {
+        RecordReader reader(body);
+        uint32_t count;
+        if (!reader.ReadHeader(RecordReader::KindTracks, total, count)) return false;
+        tracks.Reserve(body.size(), count);
+        for (uint32_t i = 0; i < count; i++) {
+            if (!ReadTrackRecord(reader, tracks)) return false;
+        }
+        return true;
+    }
 
+    // Parse tracks from a JSON array (single pass over the response buffer)
+    // or a binary record body
+    static TrackTablePtr ParseTracks(const std::string& json) {
+        MetricTimer timer(Metrics::StageParse);
+        std::shared_ptr<TrackTable> tracks = std::make_shared<TrackTable>();
+        if (RecordReader::Matches(json)) {
+            int total;
+            DecodeTrackRecords(json, *tracks, total);
+            return tracks;
+        }
+        ReserveForResponse(*tracks, json);
+        JsonReader reader(json);
+        if (reader.SeekArray()) ParseTrackArray(reader, *tracks);
+        tracks->ShrinkToFit();
         return tracks;
     }
 
-    // Parse playlists from JSON array
-    std::vector<Playlist> ParsePlaylists(const std::string& json) {
+    // Parse one /playlist_tracks page: { "total": N, "offset": O, "tracks": [...] }.
+    // A plain array (bridge without paging) is the whole playlist; total is then -1.
+    static bool ParseTrackPage(const std::string& json, TrackTable& tracks, int& total) {
+        MetricTimer timer(Metrics::StageParse);
+        total = -1;
+        if (RecordReader::Matches(json)) return DecodeTrackRecords(json, tracks, total);
+        ReserveForResponse(tracks, json);
+        JsonReader reader(json);
+        JsonReader::Token t = reader.Next();
+        if (t == JsonReader::BeginArray) {
+            ParseTrackArray(reader, tracks);
+            return true;
+        }
+        if (t != JsonReader::BeginObject) return false;
+
+        bool sawTracks = false;
+        while ((t = reader.Next()) == JsonReader::Key) {
+            bool isTotal = reader.KeyIs("total");
+            bool isTracks = reader.KeyIs("tracks");
+            JsonReader::Token v = reader.Next();
+            if (isTotal) {
+                total = reader.AsInt(v);
+            } else if (isTracks && v == JsonReader::BeginArray) {
+                ParseTrackArray(reader, tracks);
+                sawTracks = true;
+                continue;
+            }
+            if (!reader.Skip(v)) return false;
+        }
+        return sawTracks;
+    }
+
+    // Decode a binary playlist record body (see RecordReader)
+    static void DecodePlaylistRecords(const std::string& body, std::vector<Playlist>& playlists) {
+        RecordReader reader(body);
+        int total;
+        uint32_t count;
+        if (!reader.ReadHeader(RecordReader::KindPlaylists, total, count)) return;
+        playlists.reserve(count);
+
+        Playlist playlist;
+        for (uint32_t i = 0; i < count; i++) {
+            uint32_t trackCount;
+            if (!reader.ReadString(playlist.playlistId) || !reader.ReadString(playlist.title) ||
+                !reader.ReadString(playlist.thumbnail) || !reader.ReadU32(trackCount)) {
+                return;
+            }
+            playlist.count = (int)trackCount;
+            if (!playlist.playlistId.empty() && !playlist.title.empty()) {
+                playlists.push_back(std::move(playlist));
+            }
+        }
+    }
+
+    // Parse playlists from a JSON array (single pass over the response buffer)
+    // or a binary record body
+    static std::vector<Playlist> ParsePlaylists(const std::string& json) {
+        MetricTimer timer(Metrics::StageParse);
         std::vector<Playlist> playlists;
-        std::vector<std::string> items = SimpleJSON::ExtractArray(json);
+        if (RecordReader::Matches(json)) {
+            DecodePlaylistRecords(json, playlists);
+            return playlists;
+        }
+        JsonReader reader(json);
+        if (!reader.SeekArray()) return playlists;
+
+        Playlist playlist;
+        for (;;) {
+            JsonReader::Token t = reader.Next();
+            if (t != JsonReader::BeginObject) {
+                if (t == JsonReader::EndArray || !reader.Skip(t)) break;
+                continue;
+            }
+
+            playlist.playlistId.clear();
+            playlist.title.clear();
+            playlist.thumbnail.clear();
+            playlist.count = 0;
 
-        for (const auto& item : items) {
-            Playlist playlist;
-            playlist.playlistId = SimpleJSON::ExtractString(item, "playlistId");
-            playlist.title = SimpleJSON::ExtractString(item, "title");
-            playlist.count = SimpleJSON::ExtractInt(item, "count");
-            playlist.thumbnail = SimpleJSON::ExtractString(item, "thumbnail");
+            while ((t = reader.Next()) == JsonReader::Key) {
+                std::string* field = nullptr;
+                bool isCount = false;
+                if (reader.KeyIs("playlistId")) field = &playlist.playlistId;
+                else if (reader.KeyIs("title")) field = &playlist.title;
+                else if (reader.KeyIs("thumbnail")) field = &playlist.thumbnail;
+                else if (reader.KeyIs("count")) isCount = true;
+
+                JsonReader::Token v = reader.Next();
+                if (field && v == JsonReader::String) reader.ReadString(*field);
+                else if (isCount) playlist.count = reader.AsInt(v);
+                if (!reader.Skip(v)) return playlists;
+            }
+            if (t != JsonReader::EndObject) break;
 
             if (!playlist.playlistId.empty() && !playlist.title.empty()) {
-                playlists.push_back(playlist);
+                playlists.push_back(std::move(playlist));
             }
         }
 
@@ -678,15 +6359,40 @@ private:
     }
 
 public:
-    YouTubeMusicPlugin() : backendRunning(false), pythonProcess(NULL) {}
+    YouTubeMusicPlugin() : streamCache(httpClient, GetDataFilePath("stream_urls.cache")),
+        urlBatcher(httpClient, streamCache),
+        localIndex(GetDataFilePath("track_index.bin")),
+        audioCache(httpClient, GetDataFilePath("audio_cache")),
+        proxy(audioCache),
+        thumbnails(httpClient, GetDataFilePath("thumbnails")),
+        prefetcher(httpClient, workers, streamCache, audioCache),
+        nextTracks(httpClient, streamCache, urlBatcher, audioCache),
+        searchCache((size_t)SearchCacheMaxEntries, (size_t)SearchCacheMaxBytes),
+        playlistStore(GetDataFilePath("playlists")),
+        backend(httpClient),
+        workers(BackgroundThreads),
+        warmup(PlaylistWarmupParallelism) {}
 
     ~YouTubeMusicPlugin() {
-#ifdef VDJ_WIN
-        if (pythonProcess) {
-            TerminateProcess(pythonProcess, 0);
-            CloseHandle(pythonProcess);
-        }
-#endif
+        prefetcher.Cancel();
+        warmup.Shutdown();
+        workers.Shutdown();
+        nextTracks.Stop();
+        Logger::Log("NextTrackPrefetcher: " + nextTracks.StatsString());
+        localIndex.Close();
+        urlBatcher.Stop();
+        Logger::Log("StreamUrlBatcher: " + urlBatcher.StatsString());
+        streamCache.Stop();
+        Logger::Log("StreamUrlCache: " + streamCache.StatsString());
+        audioCache.Stop();
+        proxy.Stop();
+        Logger::Log("AudioCache: " + audioCache.StatsString());
+        thumbnails.Stop();
+        Logger::Log("ThumbnailCache: " + thumbnails.StatsString());
+        backend.Stop();
+        Metrics::StopExport();
+        Metrics::WriteSnapshot(GetDataFilePath("metrics.json"));
+        Logger::Shutdown();
     }
 
     //////////////////////////////////////////////////////////////////////////
@@ -695,12 +6401,28 @@ public:
     HRESULT VDJ_API OnLoad() {
         Logger::Log("=== YouTube Music Plugin Loading ===");
         Logger::Log("OnLoad: Plugin initialized");
+        Logger::Log("OnLoad: Bridge transport = " + httpClient.TransportName());
+#ifdef VDJ_WIN
+        if (!BridgeSocketPath.empty()) Logger::Log("OnLoad: BridgeSocketPath is not supported on Windows, using TCP");
+#endif
+
+        Metrics::StartExport(GetDataFilePath("metrics.json"), MetricsExportSeconds);
+        if (LocalIndexEnabled) workers.Submit([this] { localIndex.Open(); });
+        streamCache.Load();
+        streamCache.Start();
+        urlBatcher.Start();
+        audioCache.Start();
+        if (audioCache.IsRunning()) proxy.Start();
+        nextTracks.Start();
+        if (ThumbnailCacheEnabled) thumbnails.Start();
         
-        // Try to start backend
+        // Start health monitoring, then launch the backend if needed
+        backend.Start();
         bool started = EnsureBackendRunning();
         if (started) {
             Logger::Log("OnLoad: Backend started successfully");
             EnsureAuthUI();
+            if (PlaylistWarmup) warmup.Submit([this] { WarmUpPlaylists(); });
         } else {
             Logger::Error("OnLoad: Failed to start backend");
         }
@@ -724,42 +6446,113 @@ public:
     HRESULT VDJ_API OnSearch(const char* search, IVdjTracksList* tracksList) {
         Logger::Log("=== OnSearch called ===");
         Logger::Log("OnSearch: Query = '" + std::string(search) + "'");
-        
-        if (!EnsureBackendRunning()) {
-            Logger::Error("OnSearch: Backend not available");
-            return E_FAIL;
+
+        // A new query supersedes (and aborts) the previous one
+        CancelTokenPtr token = std::make_shared<CancelToken>();
+        BeginSearch(token);
+        struct SearchScope {
+            YouTubeMusicPlugin* self;
+            CancelTokenPtr token;
+            ~SearchScope() { self->EndSearch(token); }
+        } scope = { this, token };
+
+        // Tracks seen before match in milliseconds; they are listed after the
+        // bridge's results, or on their own when the bridge is unreachable
+        TrackTablePtr local;
+        if (LocalIndexEnabled) {
+            size_t maxLocal = (size_t)LocalSearchMaxResults;
+            local = localIndex.Search(search, maxLocal);
+            // Few exact matches: add near-matches in case the query has a typo
+            if (FuzzyMatchPercent > 0 && (!local || local->Size() < maxLocal)) {
+                TrackTablePtr fuzzy = localIndex.FuzzySearch(search, maxLocal, FuzzyMatchPercent);
+                local = local ? MergeTracks(local, fuzzy) : fuzzy;
+                if (local && local->Size() > maxLocal) local = TruncateTracks(local, maxLocal);
+            }
         }
 
+        std::string cacheKey = SearchCache::NormalizeQuery(search);
         std::string endpoint = "/search?q=" + UrlEncode(search);
-        Logger::Log("OnSearch: Endpoint = " + endpoint);
-        Logger::Log("OnSearch: Making HTTP request...");
-        
-        std::string response = httpClient.Get(endpoint);
+        bool needsRevalidation = false;
+        TrackTablePtr cached = searchCache.Get(cacheKey, SearchRevalidateAfter, needsRevalidation);
+        TrackTablePtr tracks;
 
-        if (response.empty()) {
-            Logger::Error("OnSearch: Empty response from backend");
-            return E_FAIL;
+        Metrics::Count(cached ? Metrics::SearchCacheHits : Metrics::SearchCacheMisses);
+        if (cached) {
+            Logger::Log("OnSearch: Served from search cache");
+            tracks = cached;
+            if (needsRevalidation) {
+                workers.Submit([this, cacheKey, endpoint] { RevalidateSearch(cacheKey, endpoint); });
+            }
+        } else {
+            // Coalesce keystrokes: only a query that stays current for the
+            // debounce window reaches the bridge
+            if (!DebounceSearch(token)) {
+                Logger::Log("OnSearch: Superseded before request, skipping");
+                return S_OK;
+            }
+
+            std::string response;
+            if (!EnsureBackendRunning()) {
+                Logger::Error("OnSearch: Backend not available");
+            } else {
+                Logger::Log("OnSearch: Endpoint = " + endpoint);
+                Logger::Log("OnSearch: Making HTTP request...");
+
+                HttpRequestOptions options;
+                options.cancel = token;
+                options.compact = true;
+                response = httpClient.Get(endpoint, options);
+
+                if (token->IsCancelled()) {
+                    Logger::Log("OnSearch: Search cancelled");
+                    return S_OK;
+                }
+                if (response.empty()) Logger::Error("OnSearch: Empty response from backend");
+            }
+
+            if (response.empty()) {
+                // Offline: show what the local index knows
+                if (!local || local->Empty()) return E_FAIL;
+                Logger::Log("OnSearch: Showing " + std::to_string(local->Size()) + " local matches");
+                tracks = std::move(local);
+            } else {
+                Logger::Log("OnSearch: Response received (" + std::to_string(response.length()) + " bytes)");
+                YTLOG_DEBUG("OnSearch: Response preview: " + response.substr(0, 200));
+
+                tracks = ParseTracks(response);
+                searchCache.Put(cacheKey, tracks);
+                RememberTracks(tracks);
+                if (token->IsCancelled()) return S_OK;
+            }
         }
-        
-        Logger::Log("OnSearch: Response received (" + std::to_string(response.length()) + " bytes)");
-        Logger::Log("OnSearch: Response preview: " + response.substr(0, 200));
+        tracks = MergeTracks(tracks, local);
 
         std::lock_guard<std::mutex> lock(dataMutex);
-        searchResults = ParseTracks(response);
+        searchResults = std::move(tracks);
         
-        Logger::Log("OnSearch: Parsed " + std::to_string(searchResults.size()) + " tracks");
+        const TrackTable& results = *searchResults;
+        Logger::Log("OnSearch: Parsed " + std::to_string(results.Size()) + " tracks");
+
+        // Resolve stream URLs for the top results while the DJ is browsing
+        std::vector<std::string> prefetchIds;
+        for (const auto& track : results) {
+            if ((int)prefetchIds.size() >= PrefetchCount) break;
+            prefetchIds.push_back(results.Str(track.videoId));
+        }
+        prefetcher.Start(prefetchIds, PrefetchCount);
 
-        for (const auto& track : searchResults) {
-            Logger::Log("OnSearch: Adding track: " + track.title + " by " + track.artist);
+        for (const auto& track : results) {
+            YTLOG_DEBUG("OnSearch: Adding track: " + std::string(results.Str(track.title)) + " by " + results.Str(track.artist));
+            std::string cover = thumbnails.CoverFor(results.Str(track.thumbnail));
             tracksList->add(
-                track.videoId.c_str(),
-                track.title.c_str(),
-                track.artist.c_str(),
+                results.Str(track.videoId),
+                results.Str(track.title),
+                results.Str(track.artist),
                 nullptr, // remix
                 nullptr, // genre
                 nullptr, // label
-                track.album.c_str(), // comment (using album)
-                track.thumbnail.c_str(), // coverUrl
+                results.Str(track.album), // comment (using album)
+                cover.c_str(), // coverUrl
                 nullptr, // streamUrl (will provide later via GetStreamUrl)
                 track.duration,
                 0.0f, // bpm
@@ -769,6 +6562,7 @@ public:
                 false // isKaraoke
             );
         }
+        thumbnails.Prefetch(results);
 
         Logger::Log("OnSearch: Search completed successfully");
         return S_OK;
@@ -776,13 +6570,35 @@ public:
 
     HRESULT VDJ_API OnSearchCancel() {
         Logger::Log("=== OnSearchCancel called ===");
-        // Cancel any ongoing search operations if needed
+        CancelTokenPtr token;
+        {
+            std::lock_guard<std::mutex> lock(searchMutex);
+            token = activeSearch;
+        }
+        if (token) token->Cancel();
         return S_OK;
     }
 
     HRESULT VDJ_API GetStreamUrl(const char* uniqueId, IVdjString& url, IVdjString& errorMessage) {
         Logger::Log("=== GetStreamUrl called ===");
         Logger::Log("GetStreamUrl: Video ID = " + std::string(uniqueId));
+        nextTracks.TrackLoaded(uniqueId);
+
+        std::string localPath;
+        if (audioCache.Lookup(uniqueId, localPath)) {
+            Logger::Log("GetStreamUrl: Served from audio cache (" + audioCache.StatsString() + ")");
+            streamCache.MarkInUse(uniqueId);
+            url = PathToFileUri(localPath).c_str();
+            return S_OK;
+        }
+
+        std::string cachedUrl;
+        if (streamCache.Lookup(uniqueId, cachedUrl)) {
+            Logger::Log("GetStreamUrl: Served from cache (" + streamCache.StatsString() + ")");
+            streamCache.MarkInUse(uniqueId);
+            url = PlaybackUrl(uniqueId, cachedUrl).c_str();
+            return S_OK;
+        }
         
         // Show visual feedback overlay
         feedback.Show("Downloading from YouTube...");
@@ -794,6 +6610,17 @@ public:
             return E_FAIL;
         }
 
+        // Already in a /get_urls batch in flight (opened playlist): wait for it
+        // briefly; a queued id is handed back to be requested here
+        StreamUrlInfo batched;
+        if (urlBatcher.Wait(uniqueId, batched)) {
+            feedback.Stop();
+            Logger::Log("GetStreamUrl: Resolved by batch (" + urlBatcher.StatsString() + ")");
+            streamCache.MarkInUse(uniqueId);
+            url = PlaybackUrl(uniqueId, batched.url).c_str();
+            return S_OK;
+        }
+
         std::string endpoint = "/get_url?id=" + std::string(uniqueId);
         Logger::Log("GetStreamUrl: Requesting " + endpoint);
         
@@ -812,13 +6639,12 @@ public:
         }
         
         Logger::Log("GetStreamUrl: Response received (" + std::to_string(response.length()) + " bytes)");
-        Logger::Log("GetStreamUrl: Response preview: " + response.substr(0, 400));
+        YTLOG_DEBUG("GetStreamUrl: Response preview: " + response.substr(0, 400));
 
-        std::string streamUrl = SimpleJSON::ExtractString(response, "streamUrl");
-        if (streamUrl.empty()) {
-            // Fallback: some responses might use "url" or return "detail" on error
-            streamUrl = SimpleJSON::ExtractString(response, "url");
-        }
+        // Some responses use "url" instead of "streamUrl", or return "detail" on error
+        StreamUrlInfo info;
+        ParseStreamUrlResponse(response, info);
+        const std::string& streamUrl = info.url;
         
         if (streamUrl.empty()) {
             std::string detail = SimpleJSON::ExtractString(response, "detail");
@@ -828,12 +6654,25 @@ public:
         }
 
         Logger::Log("GetStreamUrl: Stream URL = " + streamUrl.substr(0, 100) + "...");
-        url = streamUrl.c_str();
+        streamCache.Store(uniqueId, info);
+        streamCache.MarkInUse(uniqueId);
+        url = PlaybackUrl(uniqueId, streamUrl).c_str();
         return S_OK;
     }
 
     HRESULT VDJ_API GetFolderList(IVdjSubfoldersList* subfoldersList) {
-        // No subfolders
+        // One subfolder per playlist; its tracks load when it is first opened.
+        // This runs on the VDJ UI thread, so it lists the playlists already
+        // known (in memory, else the stored list) and refreshes in the background.
+        RefreshPlaylistsInBackground();
+
+        std::lock_guard<std::mutex> lock(dataMutex);
+        if (userPlaylists.empty() && PlaylistStoreEnabled) playlistStore.LoadList(userPlaylists);
+        for (const auto& playlist : userPlaylists) {
+            if (playlist.playlistId.empty()) continue;
+            subfoldersList->add(playlist.playlistId.c_str(),
+                playlist.title.empty() ? playlist.playlistId.c_str() : playlist.title.c_str());
+        }
         return S_OK;
     }
 
@@ -843,69 +6682,100 @@ public:
         }
 
         std::string folderId(folderUniqueId);
+        {
+            std::lock_guard<std::mutex> lock(dataMutex);
+            currentFolder = folderId;
+        }
 
         if (folderId == "search") {
             // Search folder - return cached search results
             std::lock_guard<std::mutex> lock(dataMutex);
-            for (const auto& track : searchResults) {
-                tracksList->add(
-                    track.videoId.c_str(),
-                    track.title.c_str(),
-                    track.artist.c_str(),
-                    nullptr, nullptr, nullptr,
-                    track.album.c_str(),
-                    track.thumbnail.c_str(),
-                    nullptr,
-                    track.duration,
-                    0.0f, 0, 0,
-                    track.isVideo,
-                    false
-                );
-            }
+            if (searchResults) AddTracks(tracksList, *searchResults);
             return S_OK;
         }
         else if (folderId == "playlists") {
-            // Load user playlists
-            std::string response = httpClient.Get("/playlists");
-            if (response.empty()) {
-                return E_FAIL;
+            // The playlists themselves are listed by GetFolderList; this
+            // only refreshes the list, it holds no tracks
+            return RefreshPlaylists(false) ? S_OK : E_FAIL;
+        }
+        else {
+            // Specific playlist - served from memory when complete and fresh,
+            // or while a background load is still filling it
+            PlaylistTrackCache::Snapshot cached;
+            bool haveComplete = false;
+            if (playlistCache.Get(folderId, cached)) {
+                auto age = std::chrono::steady_clock::now() - cached.loadedAt;
+                bool fresh = cached.complete && age < std::chrono::seconds(PlaylistCacheSeconds);
+                if (fresh || cached.loading) {
+                    Metrics::Count(Metrics::PlaylistCacheHits);
+                    if (cached.complete) SetOpenPlaylist(cached.tracks);
+                    AddTracks(tracksList, *cached.tracks);
+                    ResolvePlaylistHead(*cached.tracks);
+                    return S_OK;
+                }
+                haveComplete = cached.complete;
             }
+            Metrics::Count(Metrics::PlaylistCacheMisses);
 
-            std::lock_guard<std::mutex> lock(dataMutex);
-            userPlaylists = ParsePlaylists(response);
+            // Not in memory: the copy kept on disk, if any
+            if (!haveComplete) haveComplete = LoadStoredPlaylist(folderId, cached);
 
-            // Add playlists as "folders"
-            // Note: VDJ doesn't support nested folders in OnlineSource
-            // We'll return empty here and handle in context menu
-            return S_OK;
-        }
-        else {
-            // Specific playlist
-            std::string endpoint = "/playlist_tracks?id=" + folderId;
-            std::string response = httpClient.Get(endpoint);
+            // Known snapshot: fetch only what changed since
+            TrackTablePtr synced;
+            if (haveComplete && SyncPlaylist(folderId, cached, false, synced)) {
+                SetOpenPlaylist(synced);
+                AddTracks(tracksList, *synced);
+                ResolvePlaylistHead(*synced);
+                return S_OK;
+            }
 
-            if (response.empty()) {
+            // Stale copy: ask the bridge whether the playlist changed
+            TrackTable firstPage;
+            int total = -1;
+            HttpValidators validators;
+            PageResult result = FetchPlaylistPage(folderId, 0, false, firstPage, total,
+                haveComplete ? &cached.validators : nullptr, &validators);
+            if (result == PageUnchanged) {
+                Logger::Log("GetFolder: Playlist " + folderId + " not modified, reusing parsed tracks");
+                playlistCache.Touch(folderId);
+                SetOpenPlaylist(cached.tracks);
+                AddTracks(tracksList, *cached.tracks);
+                ResolvePlaylistHead(*cached.tracks);
+                return S_OK;
+            }
+            if (result == PageFailed) {
                 return E_FAIL;
             }
 
-            std::vector<Track> tracks = ParseTracks(response);
+            size_t pageCount = 1;
+            if (total > (int)firstPage.Size() && PlaylistPageSize > 0) {
+                pageCount = ((size_t)total + PlaylistPageSize - 1) / PlaylistPageSize;
+            }
 
-            for (const auto& track : tracks) {
-                tracksList->add(
-                    track.videoId.c_str(),
-                    track.title.c_str(),
-                    track.artist.c_str(),
-                    nullptr, nullptr, nullptr,
-                    track.album.c_str(),
-                    track.thumbnail.c_str(),
-                    nullptr,
-                    track.duration,
-                    0.0f, 0, 0,
-                    track.isVideo,
-                    false
-                );
+            if (pageCount > 1 && PlaylistProgressiveLoad && playlistCache.TryBeginLoad(folderId)) {
+                // Show the first page now, load the rest in the background
+                firstPage.ShrinkToFit();
+                TrackTablePtr shown = std::make_shared<const TrackTable>(std::move(firstPage));
+                playlistCache.Put(folderId, shown, false, validators);
+                AddTracks(tracksList, *shown);
+                ResolvePlaylistHead(*shown);
+                workers.Submit([this, folderId, shown, pageCount, validators] {
+                    CompletePlaylistLoad(folderId, shown, pageCount, validators);
+                });
+                return S_OK;
             }
 
+            std::vector<TrackTable> pages(pageCount);
+            pages[0] = std::move(firstPage);
+            bool complete = FetchPlaylistPages(folderId, 1, false, pages);
+            TrackTablePtr tracks = JoinPages(pages);
+
+            SetOpenPlaylist(tracks);
+            AddTracks(tracksList, *tracks);
+            ResolvePlaylistHead(*tracks);
+            playlistCache.Put(folderId, tracks, complete, validators);
+            if (complete) StorePlaylist(folderId, tracks, validators.etag);
+            RememberTracks(tracks);
             return S_OK;
         }
     }
@@ -929,18 +6799,18 @@ std::string GuidToString(const GUID& guid) {
 extern "C" {
     VDJ_EXPORT HRESULT VDJ_API DllGetClassObject(const GUID& rclsid, const GUID& riid, void** ppObject) {
         Logger::Log("=== DllGetClassObject called ===");
-        Logger::Log("DllGetClassObject: rclsid = " + GuidToString(rclsid));
-        Logger::Log("DllGetClassObject: riid = " + GuidToString(riid));
-        Logger::Log("DllGetClassObject: CLSID_VdjPlugin8 = " + GuidToString(CLSID_VdjPlugin8));
-        Logger::Log("DllGetClassObject: IID_IVdjPluginOnlineSource = " + GuidToString(IID_IVdjPluginOnlineSource));
-        Logger::Log("DllGetClassObject: IID_IVdjPluginBasic8 = " + GuidToString(IID_IVdjPluginBasic8));
-        Logger::Log("DllGetClassObject: IID_IVdjPluginDsp8 = " + GuidToString(IID_IVdjPluginDsp8));
-        Logger::Log("DllGetClassObject: IID_IVdjPluginBuffer8 = " + GuidToString(IID_IVdjPluginBuffer8));
-        Logger::Log("DllGetClassObject: IID_IVdjPluginVideoFx8 = " + GuidToString(IID_IVdjPluginVideoFx8));
-        Logger::Log("DllGetClassObject: IID_IVdjPluginVideoTransition8 = " + GuidToString(IID_IVdjPluginVideoTransition8));
-        Logger::Log("DllGetClassObject: IID_IVdjPluginVideoTransitionMultiDeck8 = " + GuidToString(IID_IVdjPluginVideoTransitionMultiDeck8));
+        YTLOG_DEBUG("DllGetClassObject: rclsid = " + GuidToString(rclsid));
+        YTLOG_DEBUG("DllGetClassObject: riid = " + GuidToString(riid));
+        YTLOG_DEBUG("DllGetClassObject: CLSID_VdjPlugin8 = " + GuidToString(CLSID_VdjPlugin8));
+        YTLOG_DEBUG("DllGetClassObject: IID_IVdjPluginOnlineSource = " + GuidToString(IID_IVdjPluginOnlineSource));
+        YTLOG_DEBUG("DllGetClassObject: IID_IVdjPluginBasic8 = " + GuidToString(IID_IVdjPluginBasic8));
+        YTLOG_DEBUG("DllGetClassObject: IID_IVdjPluginDsp8 = " + GuidToString(IID_IVdjPluginDsp8));
+        YTLOG_DEBUG("DllGetClassObject: IID_IVdjPluginBuffer8 = " + GuidToString(IID_IVdjPluginBuffer8));
+        YTLOG_DEBUG("DllGetClassObject: IID_IVdjPluginVideoFx8 = " + GuidToString(IID_IVdjPluginVideoFx8));
+        YTLOG_DEBUG("DllGetClassObject: IID_IVdjPluginVideoTransition8 = " + GuidToString(IID_IVdjPluginVideoTransition8));
+        YTLOG_DEBUG("DllGetClassObject: IID_IVdjPluginVideoTransitionMultiDeck8 = " + GuidToString(IID_IVdjPluginVideoTransitionMultiDeck8));
 #ifdef _WIN32
-    Logger::Log("DllGetClassObject: IID_IUnknown = " + GuidToString(IID_IUnknown));
+    YTLOG_DEBUG("DllGetClassObject: IID_IUnknown = " + GuidToString(IID_IUnknown));
 #endif
         
     bool clsidPlugin   = memcmp(&rclsid, &CLSID_VdjPlugin8, sizeof(GUID)) == 0;
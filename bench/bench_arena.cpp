@@ -0,0 +1,174 @@
+//////////////////////////////////////////////////////////////////////////
+// bench_arena - track storage before and after TrackTable: a vector of
+// Track structs with one std::string per field against one string arena
+// plus a row vector. Times building a result, handing a cached result
+// out (copy vs shared table), joining playlist pages and re-emitting every
+// row to VirtualDJ, and prints the heap each representation holds.
+//
+//   bench_arena [--iterations N]
+
+#include "host/bench_stats.h"
+#include "host/plugin_access.h"
+#include "host/baseline.h"
+#include "host/stub_bridge.h"
+#include "host/vdj_host.h"
+
+#include <cstdio>
+
+#ifndef BRIDGE_EXAMPLES
+#define BRIDGE_EXAMPLES "bridge_api_examples.json"
+#endif
+
+namespace {
+
+std::vector<before::Track> BuildVector(const std::vector<bench::StubTrack>& source) {
+    std::vector<before::Track> tracks;
+    for (const auto& s : source) {
+        before::Track track;
+        track.videoId = s.videoId;
+        track.title = s.title;
+        track.artist = s.artist;
+        track.album = s.album;
+        track.duration = (float)s.duration;
+        track.thumbnail = s.thumbnail;
+        track.isVideo = s.isVideo;
+        tracks.push_back(track);
+    }
+    return tracks;
+}
+
+TrackTablePtr BuildTable(const std::vector<bench::StubTrack>& source) {
+    std::shared_ptr<TrackTable> tracks = std::make_shared<TrackTable>();
+    size_t bytes = 0;
+    for (const auto& s : source)
+        bytes += s.videoId.size() + s.title.size() + s.artist.size() + s.album.size() + s.thumbnail.size() + 5;
+    tracks->Reserve(bytes, source.size());
+    for (const auto& s : source) {
+        TrackTable::Row row = TrackTable::Row();
+        row.videoId = tracks->AddString(s.videoId.data(), s.videoId.size());
+        row.title = tracks->AddString(s.title.data(), s.title.size());
+        row.artist = tracks->AddString(s.artist.data(), s.artist.size());
+        row.album = tracks->AddString(s.album.data(), s.album.size());
+        row.thumbnail = tracks->AddString(s.thumbnail.data(), s.thumbnail.size());
+        row.duration = (float)s.duration;
+        row.isVideo = s.isVideo;
+        tracks->AddRow(row);
+    }
+    return tracks;
+}
+
+// Heap held by the vector: its buffer plus every string too long for SSO
+size_t VectorBytes(const std::vector<before::Track>& tracks) {
+    size_t bytes = sizeof(tracks) + tracks.capacity() * sizeof(before::Track);
+    std::string empty;
+    for (const auto& t : tracks) {
+        const std::string* fields[] = { &t.videoId, &t.title, &t.artist, &t.album, &t.thumbnail };
+        for (const std::string* field : fields)
+            if (field->capacity() > empty.capacity()) bytes += field->capacity() + 1;
+    }
+    return bytes;
+}
+
+// What AddTracks does per row, minus the cover lookup both sides share
+void EmitVector(IVdjTracksList* list, const std::vector<before::Track>& tracks) {
+    for (const auto& t : tracks) {
+        list->add(t.videoId.c_str(), t.title.c_str(), t.artist.c_str(), nullptr, nullptr, nullptr,
+            t.album.c_str(), t.thumbnail.c_str(), nullptr, t.duration, 0.0f, 0, 0, t.isVideo, false);
+    }
+}
+
+void EmitTable(IVdjTracksList* list, const TrackTable& tracks) {
+    for (const auto& t : tracks) {
+        list->add(tracks.Str(t.videoId), tracks.Str(t.title), tracks.Str(t.artist), nullptr, nullptr, nullptr,
+            tracks.Str(t.album), tracks.Str(t.thumbnail), nullptr, t.duration, 0.0f, 0, 0, t.isVideo, false);
+    }
+}
+
+}
+
+int main(int argc, char** argv) {
+    int iterations = bench::ParseIterations(argc, argv, 1000);
+    if (iterations < 0) {
+        fprintf(stderr, "usage: %s [--iterations N]\n", argv[0]);
+        return 2;
+    }
+
+    bench::BridgePayloads payloads;
+    std::string error;
+    if (!payloads.Load(BRIDGE_EXAMPLES, error)) {
+        fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+    payloads.SetMediaBase("http://127.0.0.1:8000");
+
+    bench::LatencyStats::PrintHeader();
+    uint64_t failures = 0;
+    auto report = [&failures](const std::string& name, const bench::LatencyStats& stats) {
+        stats.Print(name);
+        failures += stats.Failures();
+    };
+
+    std::vector<std::string> memory;
+    const int trackCounts[] = { 500, 5000 };
+    for (int count : trackCounts) {
+        std::vector<bench::StubTrack> source = payloads.Tracks("bench", 0, count);
+        std::string label = std::to_string(count) + " tracks ";
+        size_t rows = (size_t)count;
+
+        report(label + "build: strings", bench::Measure(iterations, [&](int) {
+            return BuildVector(source).size() == rows;
+        }));
+        report(label + "build: arena", bench::Measure(iterations, [&](int) {
+            return BuildTable(source)->Size() == rows;
+        }));
+
+        // A cache hit: the old code copied the vector, tables are shared
+        std::vector<before::Track> vector = BuildVector(source);
+        TrackTablePtr table = BuildTable(source);
+        report(label + "cache hit: copy", bench::Measure(iterations, [&](int) {
+            std::vector<before::Track> copy = vector;
+            return copy.size() == rows;
+        }));
+        report(label + "cache hit: shared", bench::Measure(iterations, [&](int) {
+            TrackTablePtr shared = table;
+            return shared->Size() == rows;
+        }));
+
+        // A playlist arriving in pages of 200
+        std::vector<std::vector<before::Track> > vectorPages;
+        std::vector<TrackTablePtr> tablePages;
+        for (int offset = 0; offset < count; offset += 200) {
+            std::vector<bench::StubTrack> page(source.begin() + offset, source.begin() + std::min(count, offset + 200));
+            vectorPages.push_back(BuildVector(page));
+            tablePages.push_back(BuildTable(page));
+        }
+        report(label + "join pages: strings", bench::Measure(iterations, [&](int) {
+            std::vector<before::Track> joined;
+            for (const auto& page : vectorPages) joined.insert(joined.end(), page.begin(), page.end());
+            return joined.size() == rows;
+        }));
+        report(label + "join pages: arena", bench::Measure(iterations, [&](int) {
+            TrackTable joined;
+            for (const auto& page : tablePages) joined.Append(*page);
+            return joined.Size() == rows;
+        }));
+
+        report(label + "emit: strings", bench::Measure(iterations, [&](int) {
+            bench::MockTracksList list;
+            EmitVector(&list, vector);
+            return list.Rows() == rows && list.Bytes() > 0;
+        }));
+        report(label + "emit: arena", bench::Measure(iterations, [&](int) {
+            bench::MockTracksList list;
+            EmitTable(&list, *table);
+            return list.Rows() == rows && list.Bytes() > 0;
+        }));
+
+        memory.push_back(label + "held: strings " + std::to_string(VectorBytes(vector) / 1024) + " KB, arena " +
+            std::to_string(table->Bytes() / 1024) + " KB");
+    }
+
+    printf("\n");
+    for (const auto& line : memory) printf("%s\n", line.c_str());
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,176 @@
+//////////////////////////////////////////////////////////////////////////
+// bench_index - the local track index (LocalTrackIndex) at 100k and 1M
+// tracks: adding tracks, loading the file at startup, token search, and
+// typo-tolerant FuzzySearch, plus the bare trigram signature scan that
+// FuzzySearch is built on, once per signature kernel the CPU supports
+// (FuzzySearch itself uses the fastest).
+//
+//   bench_index [--iterations N] [--entries N]
+
+#include "host/bench_stats.h"
+#include "host/plugin_access.h"
+
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <random>
+
+namespace {
+
+// Made-up names from a fixed syllable list, so there are many distinct
+// words (like a real catalog) and every run indexes the same tracks
+class Catalog {
+private:
+    std::mt19937 random;
+    std::vector<std::string> artists;
+
+    std::string Word() {
+        static const char* syllables[] = {
+            "ka", "lo", "mi", "ra", "ven", "tor", "sa", "dre", "ni", "mo", "lux", "pe", "ta", "zor",
+            "bel", "qui", "fa", "ro", "den", "shi", "vo", "lan", "ga", "rin", "ty", "mar", "el", "os" };
+        const size_t count = sizeof(syllables) / sizeof(syllables[0]);
+        std::string word;
+        int length = 2 + (int)(random() % 2);
+        for (int i = 0; i < length; i++) word += syllables[random() % count];
+        return word;
+    }
+
+    std::string Words(int min, int max) {
+        std::string text;
+        int count = min + (int)(random() % (max - min + 1));
+        for (int i = 0; i < count; i++) text += (i ? " " : "") + Word();
+        return text;
+    }
+
+public:
+    Catalog() : random(20240601) {
+        for (int i = 0; i < 20000; i++) artists.push_back(Words(1, 2));
+    }
+
+    void Fill(TrackTable& tracks, size_t first, size_t count) {
+        for (size_t i = first; i < first + count; i++) {
+            std::string id = "idx" + std::to_string(i);
+            std::string title = Words(1, 4);
+            const std::string& artist = artists[random() % artists.size()];
+            std::string album = Words(1, 3);
+            std::string thumbnail = "https://i.ytimg.com/vi/" + id + "/hqdefault.jpg";
+            TrackTable::Row row = TrackTable::Row();
+            row.videoId = tracks.AddString(id.data(), id.size());
+            row.title = tracks.AddString(title.data(), title.size());
+            row.artist = tracks.AddString(artist.data(), artist.size());
+            row.album = tracks.AddString(album.data(), album.size());
+            row.thumbnail = tracks.AddString(thumbnail.data(), thumbnail.size());
+            row.duration = 180.0f + (float)(i % 120);
+            tracks.AddRow(row);
+        }
+    }
+};
+
+// The query with two neighbouring letters swapped, as when typing fast
+std::string Typo(const std::string& text) {
+    std::string typo = text;
+    size_t i = typo.size() / 2;
+    if (i + 1 < typo.size()) std::swap(typo[i], typo[i + 1]);
+    return typo;
+}
+
+}
+
+int main(int argc, char** argv) {
+    int iterations = 200;
+    std::vector<size_t> sizes = { 100000, 1000000 };
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) iterations = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--entries") == 0 && i + 1 < argc) sizes = { (size_t)atol(argv[++i]) };
+        else iterations = -1;
+    }
+    if (iterations <= 0 || sizes[0] == 0) {
+        fprintf(stderr, "usage: %s [--iterations N] [--entries N]\n", argv[0]);
+        return 2;
+    }
+
+    char dataTemplate[] = "/tmp/bench_index.XXXXXX";
+    if (!mkdtemp(dataTemplate)) {
+        perror("mkdtemp");
+        return 1;
+    }
+    BPath = dataTemplate;
+    LogLevel = 2;
+    LocalIndexMaxBytes = INT_MAX;       // keep every track; the default cap would evict most of them
+
+    TrigramSignature::Kernel best = TrigramSignature::BestKernel();
+    printf("signature kernel: %s\n\n", TrigramSignature::KernelName(best));
+    bench::LatencyStats::PrintHeader();
+    uint64_t failures = 0;
+    auto report = [&failures](const std::string& name, const bench::LatencyStats& stats) {
+        stats.Print(name);
+        failures += stats.Failures();
+    };
+
+    const size_t Batch = 1000;          // tracks per Add(), like a large playlist page
+    for (size_t entries : sizes) {
+        std::string label = std::to_string(entries / 1000) + "k ";
+        std::string path = std::string(dataTemplate) + "/track_index_" + std::to_string(entries) + ".bin";
+        Catalog catalog;
+        TrackTable all;
+        catalog.Fill(all, 0, entries);
+
+        {
+            LocalTrackIndex index(path);
+            index.Open();
+            int batches = (int)((entries + Batch - 1) / Batch);
+            report(label + "Add, 1000 tracks", bench::Measure(batches, [&](int b) {
+                TrackTable batch;
+                size_t first = (size_t)b * Batch;
+                for (size_t i = first; i < std::min(entries, first + Batch); i++) batch.AppendRow(all, all[i]);
+                index.Add(batch);
+                return true;
+            }));
+            index.Close();
+        }
+
+        LocalTrackIndex index(path);
+        report(label + "Open (startup)", bench::Measure(1, [&](int) {
+            return index.Open() && index.TrackCount() == entries;
+        }));
+
+        std::mt19937 pick(7);
+        report(label + "Search (artist)", bench::Measure(iterations, [&](int) {
+            const TrackTable::Row& row = all[pick() % entries];
+            TrackTablePtr found = index.Search(all.Str(row.artist), 50);
+            return found && found->Size() > 0;
+        }));
+        report(label + "FuzzySearch (typo)", bench::Measure(iterations, [&](int) {
+            const TrackTable::Row& row = all[pick() % entries];
+            std::string query = Typo(std::string(all.Str(row.artist)) + " " + all.Str(row.title));
+            TrackTablePtr found = index.FuzzySearch(query, 50, 50);
+            return found && found->Size() > 0;
+        }));
+
+        // The kernels alone: one query against every signature
+        std::vector<TrigramSignature> signatures(entries);
+        for (size_t i = 0; i < entries; i++) {
+            signatures[i].AddText(all.Str(all[i].title));
+            signatures[i].AddText(all.Str(all[i].artist));
+        }
+        for (int k = TrigramSignature::KernelScalar; k <= best; k++) {
+            TrigramSignature::Kernel kernel = (TrigramSignature::Kernel)k;
+            TrigramSignature::Matches matches;
+            report(label + "signature scan: " + TrigramSignature::KernelName(kernel), bench::Measure(iterations, [&](int) {
+                TrigramSignature wanted;
+                const TrackTable::Row& row = all[pick() % entries];
+                wanted.AddText(Typo(all.Str(row.artist)).c_str());
+                matches.clear();
+                TrigramSignature::Scan(signatures.data(), (uint32_t)entries, wanted, wanted.Count() / 2, matches, kernel);
+                return !matches.empty();
+            }));
+        }
+        index.Close();
+    }
+
+    std::error_code ignored;
+    std::filesystem::remove_all(dataTemplate, ignored);
+    return failures ? 1 : 0;
+}
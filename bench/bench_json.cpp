@@ -0,0 +1,64 @@
+//////////////////////////////////////////////////////////////////////////
+// bench_json - response parsing before and after the single-pass reader:
+// SimpleJSON (one substring per object, one find() per field) against
+// JsonReader decoding into the TrackTable arena, on /search, playlist and
+// /playlists bodies built from bridge_api_examples.json.
+//
+//   bench_json [--iterations N]
+
+#include "host/bench_stats.h"
+#include "host/plugin_access.h"
+#include "host/baseline.h"
+#include "host/stub_bridge.h"
+
+#include <cstdio>
+
+#ifndef BRIDGE_EXAMPLES
+#define BRIDGE_EXAMPLES "bridge_api_examples.json"
+#endif
+
+int main(int argc, char** argv) {
+    int iterations = bench::ParseIterations(argc, argv, 2000);
+    if (iterations < 0) {
+        fprintf(stderr, "usage: %s [--iterations N]\n", argv[0]);
+        return 2;
+    }
+
+    bench::BridgePayloads payloads;
+    std::string error;
+    if (!payloads.Load(BRIDGE_EXAMPLES, error)) {
+        fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+    payloads.SetMediaBase("http://127.0.0.1:8000");
+
+    bench::LatencyStats::PrintHeader();
+    uint64_t failures = 0;
+    auto report = [&failures](const std::string& name, const bench::LatencyStats& stats) {
+        stats.Print(name);
+        failures += stats.Failures();
+    };
+
+    const int trackCounts[] = { 50, 1000 };
+    for (int count : trackCounts) {
+        std::string json = payloads.TracksJson(payloads.Tracks("bench", 0, count));
+        std::string label = std::to_string(count) + " tracks, " + std::to_string(json.size() / 1024) + " KB";
+        report(label + ": SimpleJSON", bench::Measure(iterations, [&](int) {
+            return before::ParseTracks(json).size() == (size_t)count;
+        }));
+        report(label + ": JsonReader", bench::Measure(iterations, [&](int) {
+            return PluginBench::ParseTracks(json)->Size() == (size_t)count;
+        }));
+    }
+
+    std::string playlists = payloads.PlaylistsJson(200, 1000);
+    std::string label = "200 playlists, " + std::to_string(playlists.size() / 1024) + " KB";
+    report(label + ": SimpleJSON", bench::Measure(iterations, [&](int) {
+        return before::ParsePlaylists(playlists).size() == 200;
+    }));
+    report(label + ": JsonReader", bench::Measure(iterations, [&](int) {
+        return PluginBench::ParsePlaylists(playlists).size() == 200;
+    }));
+
+    return failures ? 1 : 0;
+}
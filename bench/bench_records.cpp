@@ -0,0 +1,90 @@
+//////////////////////////////////////////////////////////////////////////
+// bench_records - the same responses as JSON and as the binary record
+// format (application/x-ytm-records): body size and decode time for
+// /search, /playlist_tracks pages and /playlists.
+//
+//   bench_records [--iterations N]
+
+#include "host/bench_stats.h"
+#include "host/plugin_access.h"
+#include "host/stub_bridge.h"
+
+#include <cstdio>
+
+#ifndef BRIDGE_EXAMPLES
+#define BRIDGE_EXAMPLES "bridge_api_examples.json"
+#endif
+
+int main(int argc, char** argv) {
+    int iterations = bench::ParseIterations(argc, argv, 2000);
+    if (iterations < 0) {
+        fprintf(stderr, "usage: %s [--iterations N]\n", argv[0]);
+        return 2;
+    }
+
+    bench::BridgePayloads payloads;
+    std::string error;
+    if (!payloads.Load(BRIDGE_EXAMPLES, error)) {
+        fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+    payloads.SetMediaBase("http://127.0.0.1:8000");
+
+    bench::LatencyStats::PrintHeader();
+    uint64_t failures = 0;
+    auto report = [&failures](const std::string& name, const bench::LatencyStats& stats) {
+        stats.Print(name);
+        failures += stats.Failures();
+    };
+    std::vector<std::string> sizes;
+    auto size = [&sizes](const std::string& name, const std::string& json, const std::string& records) {
+        sizes.push_back(name + ": JSON " + std::to_string(json.size()) + " bytes, records " +
+            std::to_string(records.size()) + " bytes (" + std::to_string(records.size() * 100 / json.size()) + "%)");
+    };
+
+    // /search: a bare array of tracks
+    std::vector<bench::StubTrack> search = payloads.Tracks("bench", 0, 50);
+    std::string searchJson = payloads.TracksJson(search);
+    std::string searchRecords = payloads.TracksRecords(search, 0xFFFFFFFFu);
+    size("/search, 50 tracks", searchJson, searchRecords);
+    report("/search 50: JSON", bench::Measure(iterations, [&](int) {
+        return PluginBench::ParseTracks(searchJson)->Size() == 50;
+    }));
+    report("/search 50: records", bench::Measure(iterations, [&](int) {
+        return PluginBench::ParseTracks(searchRecords)->Size() == 50;
+    }));
+
+    // /playlist_tracks: one page, and a whole playlist from a bridge without paging
+    const int pageSizes[] = { 200, 5000 };
+    for (int count : pageSizes) {
+        std::vector<bench::StubTrack> page = payloads.Tracks("PL", 0, count);
+        std::string pageJson = payloads.PlaylistPageJson(page, 5000, 0, count);
+        std::string pageRecords = payloads.TracksRecords(page, 5000);
+        std::string label = "/playlist_tracks " + std::to_string(count);
+        size(label, pageJson, pageRecords);
+        report(label + ": JSON", bench::Measure(iterations, [&](int) {
+            TrackTable tracks;
+            int total;
+            return PluginBench::ParseTrackPage(pageJson, tracks, total) && tracks.Size() == (size_t)count;
+        }));
+        report(label + ": records", bench::Measure(iterations, [&](int) {
+            TrackTable tracks;
+            int total;
+            return PluginBench::ParseTrackPage(pageRecords, tracks, total) && tracks.Size() == (size_t)count;
+        }));
+    }
+
+    std::string playlistsJson = payloads.PlaylistsJson(200, 1000);
+    std::string playlistsRecords = payloads.PlaylistsRecords(200, 1000);
+    size("/playlists, 200 playlists", playlistsJson, playlistsRecords);
+    report("/playlists 200: JSON", bench::Measure(iterations, [&](int) {
+        return PluginBench::ParsePlaylists(playlistsJson).size() == 200;
+    }));
+    report("/playlists 200: records", bench::Measure(iterations, [&](int) {
+        return PluginBench::ParsePlaylists(playlistsRecords).size() == 200;
+    }));
+
+    printf("\n");
+    for (const auto& line : sizes) printf("%s\n", line.c_str());
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,99 @@
+//////////////////////////////////////////////////////////////////////////
+// bench_transport - bridge round trips over loopback TCP (the only
+// transport before BridgeSocketPath) and over a Unix domain socket, through
+// the plugin's HttpClient against the stub bridge with no added latency.
+// Single requests first, then four threads at once as with several decks.
+//
+//   bench_transport [--iterations N]
+
+#include "host/bench_stats.h"
+#include "host/plugin_access.h"
+#include "host/stub_bridge.h"
+
+#include <unistd.h>
+
+#include <cstdio>
+#include <thread>
+
+#ifndef BRIDGE_EXAMPLES
+#define BRIDGE_EXAMPLES "bridge_api_examples.json"
+#endif
+
+namespace {
+
+const int Threads = 4;
+
+bench::LatencyStats Concurrent(HttpClient& client, int iterations) {
+    std::vector<bench::LatencyStats> perThread(Threads);
+    std::vector<std::thread> threads;
+    bench::Clock::time_point start = bench::Clock::now();
+    for (int t = 0; t < Threads; t++) {
+        threads.emplace_back([&, t] {
+            perThread[t] = bench::Measure(iterations, [&](int i) {
+                return !client.Get("/get_url?id=t" + std::to_string(t) + "-" + std::to_string(i)).empty();
+            });
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    bench::LatencyStats merged;
+    for (const auto& stats : perThread) merged.Merge(stats);
+    merged.SetWallSeconds(bench::MicrosecondsSince(start) / 1e6);
+    return merged;
+}
+
+}
+
+int main(int argc, char** argv) {
+    int iterations = bench::ParseIterations(argc, argv, 5000);
+    if (iterations < 0) {
+        fprintf(stderr, "usage: %s [--iterations N]\n", argv[0]);
+        return 2;
+    }
+
+    bench::StubBridgeOptions options;
+    options.examplesPath = BRIDGE_EXAMPLES;
+    options.socketPath = "/tmp/bench_transport." + std::to_string(getpid()) + ".sock";
+    bench::StubBridge bridge(options);
+    std::string error;
+    if (!bridge.Start(error)) {
+        fprintf(stderr, "stub bridge: %s\n", error.c_str());
+        return 1;
+    }
+
+    // HttpClient reads the transport settings when it is constructed
+    BPath = "/tmp";
+    LogLevel = 2;
+    BridgePort = bridge.Port();
+    BridgeSocketPath = "";
+    HttpClient tcp;
+    BridgeSocketPath = options.socketPath;
+    HttpClient unixSocket;
+
+    bench::LatencyStats::PrintHeader();
+    uint64_t failures = 0;
+    auto report = [&failures](const std::string& name, const bench::LatencyStats& stats) {
+        stats.Print(name);
+        failures += stats.Failures();
+    };
+
+    struct Transport { const char* name; HttpClient* client; };
+    const Transport transports[] = { { "tcp", &tcp }, { "unix", &unixSocket } };
+    for (const Transport& transport : transports) {
+        HttpClient& client = *transport.client;
+        std::string name = transport.name;
+        client.Get("/");    // connect before timing
+        report("/ (" + name + ")", bench::Measure(iterations, [&](int) {
+            return !client.Get("/").empty();
+        }));
+        report("/get_url (" + name + ")", bench::Measure(iterations, [&](int i) {
+            return !client.Get("/get_url?id=bench-" + std::to_string(i)).empty();
+        }));
+        report("/search 50 tracks (" + name + ")", bench::Measure(iterations, [&](int i) {
+            return !client.Get("/search?q=bench+" + std::to_string(i)).empty();
+        }));
+        report("/get_url x" + std::to_string(Threads) + " threads (" + name + ")", Concurrent(client, iterations));
+    }
+
+    bridge.Stop();
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,28 @@
+//////////////////////////////////////////////////////////////////////////
+// AllocCounter - counts heap allocations per thread, by replacing the
+// global operator new for the whole benchmark binary. Calls made from the
+// measuring thread show up; the plugin's own background threads do not.
+
+#ifndef BENCH_ALLOC_COUNTER_H
+#define BENCH_ALLOC_COUNTER_H
+
+#include <cstdint>
+
+namespace bench {
+
+// operator new calls made by the calling thread so far
+uint64_t ThreadAllocations();
+
+// Allocations made by the calling thread while the scope is alive
+class AllocScope {
+private:
+    uint64_t start;
+
+public:
+    AllocScope() : start(ThreadAllocations()) {}
+    uint64_t Count() const { return ThreadAllocations() - start; }
+};
+
+}
+
+#endif
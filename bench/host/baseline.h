@@ -0,0 +1,65 @@
+//////////////////////////////////////////////////////////////////////////
+// The plugin's track storage and parsers before the optimizations, for the
+// "before" side of the microbenchmarks. Include after plugin_access.h.
+
+#ifndef BENCH_BASELINE_H
+#define BENCH_BASELINE_H
+
+namespace before {
+
+// One std::string per field, as before TrackTable
+struct Track {
+    std::string videoId;
+    std::string title;
+    std::string artist;
+    std::string album;
+    float duration;
+    std::string thumbnail;
+    bool isVideo;
+};
+
+// SimpleJSON parsers, as they were before JsonReader
+inline std::vector<Track> ParseTracks(const std::string& json) {
+    std::vector<Track> tracks;
+    std::vector<std::string> items = SimpleJSON::ExtractArray(json);
+
+    for (const auto& item : items) {
+        Track track;
+        track.videoId = SimpleJSON::ExtractString(item, "videoId");
+        track.title = SimpleJSON::ExtractString(item, "title");
+        track.artist = SimpleJSON::ExtractString(item, "artist");
+        track.album = SimpleJSON::ExtractString(item, "album");
+        track.duration = (float)SimpleJSON::ExtractInt(item, "duration");
+        track.thumbnail = SimpleJSON::ExtractString(item, "thumbnail");
+        track.isVideo = SimpleJSON::ExtractBool(item, "isVideo");
+
+        if (!track.videoId.empty() && !track.title.empty()) {
+            tracks.push_back(track);
+        }
+    }
+
+    return tracks;
+}
+
+inline std::vector<Playlist> ParsePlaylists(const std::string& json) {
+    std::vector<Playlist> playlists;
+    std::vector<std::string> items = SimpleJSON::ExtractArray(json);
+
+    for (const auto& item : items) {
+        Playlist playlist;
+        playlist.playlistId = SimpleJSON::ExtractString(item, "playlistId");
+        playlist.title = SimpleJSON::ExtractString(item, "title");
+        playlist.count = SimpleJSON::ExtractInt(item, "count");
+        playlist.thumbnail = SimpleJSON::ExtractString(item, "thumbnail");
+
+        if (!playlist.playlistId.empty() && !playlist.title.empty()) {
+            playlists.push_back(playlist);
+        }
+    }
+
+    return playlists;
+}
+
+}
+
+#endif
@@ -0,0 +1,51 @@
+#include "alloc_counter.h"
+#include "bench_stats.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <numeric>
+
+namespace bench {
+
+double LatencyStats::Percentile(double p) const {
+    if (samples.empty()) return 0;
+    std::vector<double> sorted(samples);
+    std::sort(sorted.begin(), sorted.end());
+    size_t index = (size_t)(p / 100.0 * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+double LatencyStats::Mean() const {
+    if (samples.empty()) return 0;
+    return std::accumulate(samples.begin(), samples.end(), 0.0) / samples.size();
+}
+
+void LatencyStats::PrintHeader() {
+    printf("%-36s %7s %10s %10s %10s %10s %12s %10s\n",
+        "scenario", "calls", "p50 us", "p95 us", "p99 us", "max us", "allocs/call", "calls/s");
+}
+
+void LatencyStats::Print(const std::string& name) const {
+    double seconds = wallSeconds > 0 ? wallSeconds : Mean() * samples.size() / 1e6;
+    double perSecond = seconds > 0 ? samples.size() / seconds : 0;
+    double allocsPerCall = samples.empty() ? 0 : (double)allocations / samples.size();
+    printf("%-36s %7zu %10.1f %10.1f %10.1f %10.1f %12.1f %10.0f",
+        name.c_str(), samples.size(), Percentile(50), Percentile(95), Percentile(99), Percentile(100),
+        allocsPerCall, perSecond);
+    if (failures) printf("  (%llu failed)", (unsigned long long)failures);
+    printf("\n");
+    fflush(stdout);
+}
+
+int ParseIterations(int argc, char** argv, int fallback) {
+    int iterations = fallback;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) iterations = atoi(argv[++i]);
+        else return -1;
+    }
+    return iterations > 0 ? iterations : -1;
+}
+
+}
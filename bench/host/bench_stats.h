@@ -0,0 +1,79 @@
+//////////////////////////////////////////////////////////////////////////
+// LatencyStats - per-call latencies of one scenario, reported as
+// p50/p95/p99/max, heap allocations per call and calls per second.
+// Each thread records into its own instance; Merge() combines them.
+
+#ifndef BENCH_STATS_H
+#define BENCH_STATS_H
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "alloc_counter.h"
+
+namespace bench {
+
+typedef std::chrono::steady_clock Clock;
+
+inline double MicrosecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+}
+
+class LatencyStats {
+private:
+    std::vector<double> samples;    // microseconds
+    uint64_t allocations;
+    uint64_t failures;
+    double wallSeconds;             // time the scenario took, for throughput
+
+public:
+    LatencyStats() : allocations(0), failures(0), wallSeconds(0) {}
+
+    void Add(double microseconds, uint64_t allocs, bool ok = true) {
+        samples.push_back(microseconds);
+        allocations += allocs;
+        if (!ok) failures++;
+    }
+
+    void Merge(const LatencyStats& other) {
+        samples.insert(samples.end(), other.samples.begin(), other.samples.end());
+        allocations += other.allocations;
+        failures += other.failures;
+    }
+
+    void SetWallSeconds(double seconds) { wallSeconds = seconds; }
+
+    size_t Calls() const { return samples.size(); }
+    uint64_t Failures() const { return failures; }
+    double Percentile(double p) const;
+    double Mean() const;
+
+    static void PrintHeader();
+    // One aligned line; throughput uses the wall time if set, else the sum of the samples
+    void Print(const std::string& name) const;
+};
+
+// "--iterations N" from the command line, else fallback; -1 on anything else
+int ParseIterations(int argc, char** argv, int fallback);
+
+// Run call() `count` times, timing each call and counting its allocations
+template <class Call>
+LatencyStats Measure(int count, Call call) {
+    LatencyStats stats;
+    Clock::time_point begin = Clock::now();
+    for (int i = 0; i < count; i++) {
+        uint64_t allocsBefore = ThreadAllocations();
+        Clock::time_point start = Clock::now();
+        bool ok = call(i);
+        double us = MicrosecondsSince(start);
+        stats.Add(us, ThreadAllocations() - allocsBefore, ok);
+    }
+    stats.SetWallSeconds(MicrosecondsSince(begin) / 1e6);
+    return stats;
+}
+
+}
+
+#endif
@@ -0,0 +1,26 @@
+//////////////////////////////////////////////////////////////////////////
+// Includes the plugin source into a microbenchmark's translation unit, so
+// it can time classes VirtualDJ never sees (JsonReader, TrackTable, ...).
+// Such benchmarks link bench_support but not ytm_plugin. PluginBench is a
+// friend of YouTubeMusicPlugin and forwards to its private parsers.
+
+#ifndef BENCH_PLUGIN_ACCESS_H
+#define BENCH_PLUGIN_ACCESS_H
+
+#include "../../YouTubeMusicPlugin.cpp"
+
+struct PluginBench {
+    static TrackTablePtr ParseTracks(const std::string& body) {
+        return YouTubeMusicPlugin::ParseTracks(body);
+    }
+
+    static bool ParseTrackPage(const std::string& body, TrackTable& tracks, int& total) {
+        return YouTubeMusicPlugin::ParseTrackPage(body, tracks, total);
+    }
+
+    static std::vector<Playlist> ParsePlaylists(const std::string& body) {
+        return YouTubeMusicPlugin::ParsePlaylists(body);
+    }
+};
+
+#endif
@@ -0,0 +1,24 @@
+//////////////////////////////////////////////////////////////////////////
+// The plugin's settings (the globals at the top of YouTubeMusicPlugin.cpp)
+// that the benchmarks change before loading it
+
+#ifndef BENCH_PLUGIN_SETTINGS_H
+#define BENCH_PLUGIN_SETTINGS_H
+
+#include <string>
+
+extern std::string BPath;
+extern int BridgePort;
+extern std::string BridgeSocketPath;
+extern int LogLevel;
+extern int SearchDebounceMs;
+extern bool PlaylistWarmup;
+extern bool PlaylistStoreEnabled;
+extern bool AudioCacheEnabled;
+extern bool ProgressiveProxyEnabled;
+extern bool ThumbnailCacheEnabled;
+extern bool CompactResponses;
+extern bool LocalIndexEnabled;
+extern int MetricsExportSeconds;
+
+#endif
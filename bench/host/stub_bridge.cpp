@@ -0,0 +1,642 @@
+#include "stub_bridge.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+namespace bench {
+
+namespace {
+
+//////////////////////////////////////////////////////////////////////////
+// JsonValue - just enough JSON to read the example payloads
+struct JsonValue {
+    enum Type { Null, Bool, Number, String, Array, Object };
+    Type type = Null;
+    bool boolean = false;
+    double number = 0;
+    std::string text;
+    std::vector<JsonValue> items;
+    std::vector<std::pair<std::string, JsonValue> > members;
+
+    const JsonValue* Find(const std::string& key) const {
+        for (const auto& member : members)
+            if (member.first == key) return &member.second;
+        return nullptr;
+    }
+
+    std::string GetString(const std::string& key) const {
+        const JsonValue* value = Find(key);
+        return value && value->type == String ? value->text : std::string();
+    }
+
+    double GetNumber(const std::string& key) const {
+        const JsonValue* value = Find(key);
+        return value && value->type == Number ? value->number : 0;
+    }
+
+    bool GetBool(const std::string& key) const {
+        const JsonValue* value = Find(key);
+        return value && value->type == Bool && value->boolean;
+    }
+};
+
+class JsonParser {
+private:
+    const char* p;
+    const char* end;
+
+    void SkipSpace() {
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')) p++;
+    }
+
+    bool Literal(const char* word) {
+        size_t n = strlen(word);
+        if ((size_t)(end - p) < n || memcmp(p, word, n) != 0) return false;
+        p += n;
+        return true;
+    }
+
+    bool ParseString(std::string& out) {
+        if (p >= end || *p != '"') return false;
+        p++;
+        while (p < end && *p != '"') {
+            if (*p == '\\' && p + 1 < end) {
+                p++;
+                switch (*p) {
+                    case 'n': out += '\n'; break;
+                    case 't': out += '\t'; break;
+                    case 'u': out += '?'; p += 4; break;     // the examples are ASCII
+                    default: out += *p; break;
+                }
+                p++;
+            } else {
+                out += *p++;
+            }
+        }
+        if (p >= end) return false;
+        p++;
+        return true;
+    }
+
+public:
+    JsonParser(const std::string& text) : p(text.data()), end(text.data() + text.size()) {}
+
+    bool Parse(JsonValue& value) {
+        SkipSpace();
+        if (p >= end) return false;
+        if (*p == '{') {
+            value.type = JsonValue::Object;
+            p++;
+            SkipSpace();
+            if (p < end && *p == '}') { p++; return true; }
+            while (true) {
+                std::string key;
+                SkipSpace();
+                if (!ParseString(key)) return false;
+                SkipSpace();
+                if (p >= end || *p++ != ':') return false;
+                value.members.push_back(std::make_pair(key, JsonValue()));
+                if (!Parse(value.members.back().second)) return false;
+                SkipSpace();
+                if (p < end && *p == ',') { p++; continue; }
+                if (p < end && *p == '}') { p++; return true; }
+                return false;
+            }
+        }
+        if (*p == '[') {
+            value.type = JsonValue::Array;
+            p++;
+            SkipSpace();
+            if (p < end && *p == ']') { p++; return true; }
+            while (true) {
+                value.items.push_back(JsonValue());
+                if (!Parse(value.items.back())) return false;
+                SkipSpace();
+                if (p < end && *p == ',') { p++; continue; }
+                if (p < end && *p == ']') { p++; return true; }
+                return false;
+            }
+        }
+        if (*p == '"') {
+            value.type = JsonValue::String;
+            return ParseString(value.text);
+        }
+        if (Literal("true")) { value.type = JsonValue::Bool; value.boolean = true; return true; }
+        if (Literal("false")) { value.type = JsonValue::Bool; return true; }
+        if (Literal("null")) return true;
+        char* stop = nullptr;
+        value.number = strtod(p, &stop);
+        if (stop == p) return false;
+        value.type = JsonValue::Number;
+        p = stop;
+        return true;
+    }
+};
+
+// The ```json block after each "**GET /path...**" line, keyed by the request line
+std::vector<std::pair<std::string, std::string> > ExampleBlocks(const std::string& markdown) {
+    std::vector<std::pair<std::string, std::string> > blocks;
+    std::istringstream lines(markdown);
+    std::string line, target, body;
+    bool inBlock = false;
+    while (std::getline(lines, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (inBlock) {
+            if (line.compare(0, 3, "```") == 0) {
+                blocks.push_back(std::make_pair(target, body));
+                target.clear();
+                inBlock = false;
+            } else {
+                body += line + "\n";
+            }
+        } else if (line.compare(0, 6, "**GET ") == 0) {
+            target = line.substr(6, line.find("**", 6) - 6);
+        } else if (line == "```json" && !target.empty()) {
+            body.clear();
+            inBlock = true;
+        }
+    }
+    return blocks;
+}
+
+std::string JsonEscape(const std::string& value) {
+    std::string out;
+    out.reserve(value.size() + 2);
+    out += '"';
+    for (char c : value) {
+        if (c == '"' || c == '\\') out += '\\';
+        if (c == '\n') { out += "\\n"; continue; }
+        out += c;
+    }
+    out += '"';
+    return out;
+}
+
+void AppendTrackJson(std::string& out, const StubTrack& track) {
+    out += "{\"videoId\":" + JsonEscape(track.videoId) +
+        ",\"title\":" + JsonEscape(track.title) +
+        ",\"artist\":" + JsonEscape(track.artist) +
+        ",\"album\":" + JsonEscape(track.album) +
+        ",\"duration\":" + std::to_string(track.duration) +
+        ",\"thumbnail\":" + JsonEscape(track.thumbnail) +
+        ",\"isVideo\":" + (track.isVideo ? "true" : "false") + "}";
+}
+
+void PutU8(std::string& out, uint8_t v) { out += (char)v; }
+void PutU16(std::string& out, uint16_t v) { PutU8(out, v & 0xFF); PutU8(out, v >> 8); }
+void PutU32(std::string& out, uint32_t v) { PutU16(out, v & 0xFFFF); PutU16(out, v >> 16); }
+void PutString(std::string& out, const std::string& s) {
+    uint16_t n = (uint16_t)std::min<size_t>(s.size(), 0xFFFF);
+    PutU16(out, n);
+    out.append(s, 0, n);
+}
+
+void PutRecordHeader(std::string& out, uint8_t kind, uint32_t total, uint32_t count) {
+    out += "YTMR";
+    PutU8(out, 1);
+    PutU8(out, kind);
+    PutU16(out, 0);
+    PutU32(out, total);
+    PutU32(out, count);
+}
+
+uint32_t Fnv1a(const std::string& text) {
+    uint32_t hash = 2166136261u;
+    for (unsigned char c : text) hash = (hash ^ c) * 16777619u;
+    return hash;
+}
+
+std::string Hex(uint32_t value) {
+    char buf[9];
+    snprintf(buf, sizeof(buf), "%08x", value);
+    return buf;
+}
+
+std::string UrlDecode(const std::string& value) {
+    std::string out;
+    for (size_t i = 0; i < value.size(); i++) {
+        if (value[i] == '%' && i + 2 < value.size()) {
+            out += (char)strtol(value.substr(i + 1, 2).c_str(), nullptr, 16);
+            i += 2;
+        } else {
+            out += value[i] == '+' ? ' ' : value[i];
+        }
+    }
+    return out;
+}
+
+std::string QueryParam(const std::string& query, const std::string& name) {
+    size_t pos = 0;
+    while (pos <= query.size()) {
+        size_t amp = query.find('&', pos);
+        if (amp == std::string::npos) amp = query.size();
+        size_t eq = query.find('=', pos);
+        if (eq < amp && query.compare(pos, eq - pos, name) == 0 && eq - pos == name.size())
+            return UrlDecode(query.substr(eq + 1, amp - eq - 1));
+        pos = amp + 1;
+    }
+    return std::string();
+}
+
+const char* Reason(int status) {
+    switch (status) {
+        case 200: return "OK";
+        case 206: return "Partial Content";
+        case 304: return "Not Modified";
+        case 404: return "Not Found";
+        case 409: return "Conflict";
+        case 416: return "Range Not Satisfiable";
+        default: return "Error";
+    }
+}
+
+}
+
+//////////////////////////////////////////////////////////////////////////
+// BridgePayloads
+
+bool BridgePayloads::Load(const std::string& examplesPath, std::string& error) {
+    std::ifstream file(examplesPath, std::ios::binary);
+    if (!file) {
+        error = "cannot read " + examplesPath;
+        return false;
+    }
+    std::stringstream text;
+    text << file.rdbuf();
+
+    for (const auto& block : ExampleBlocks(text.str())) {
+        JsonValue value;
+        if (!JsonParser(block.second).Parse(value)) {
+            error = "bad example JSON for " + block.first;
+            return false;
+        }
+        const std::string& target = block.first;
+        std::string path = target.substr(0, target.find('?'));
+        if (path == "/") {
+            health = block.second;
+        } else if (path == "/search" && value.type == JsonValue::Array) {
+            for (const JsonValue& item : value.items) {
+                StubTrack track;
+                track.videoId = item.GetString("videoId");
+                track.title = item.GetString("title");
+                track.artist = item.GetString("artist");
+                track.album = item.GetString("album");
+                track.thumbnail = item.GetString("thumbnail");
+                track.duration = (int)item.GetNumber("duration");
+                track.isVideo = item.GetBool("isVideo");
+                trackTemplates.push_back(track);
+            }
+        } else if (path == "/playlists" && value.type == JsonValue::Array && !value.items.empty()) {
+            playlistTemplateId = value.items[0].GetString("playlistId");
+            playlistTemplateTitle = value.items[0].GetString("title");
+        } else if (path == "/get_url" && target.find("INVALID") != std::string::npos) {
+            errorDetail = value.GetString("detail");
+        } else if (path == "/get_url") {
+            streamExt = value.GetString("ext");
+            streamTtl = (int)value.GetNumber("ttl");
+        }
+    }
+
+    if (health.empty() || trackTemplates.empty() || playlistTemplateId.empty() || streamExt.empty()) {
+        error = examplesPath + " lacks the /, /search, /playlists or /get_url example";
+        return false;
+    }
+    return true;
+}
+
+std::vector<StubTrack> BridgePayloads::Tracks(const std::string& seed, int offset, int count) const {
+    std::vector<StubTrack> tracks;
+    tracks.reserve(count > 0 ? count : 0);
+    std::string tag = Hex(Fnv1a(seed));
+    for (int i = offset; i < offset + count; i++) {
+        StubTrack track = trackTemplates[i % trackTemplates.size()];
+        track.videoId += "-" + tag + "-" + std::to_string(i);
+        track.title += " (" + std::to_string(i) + ")";
+        track.thumbnail = mediaBase + "/vi/" + track.videoId + "/hqdefault.jpg";
+        tracks.push_back(track);
+    }
+    return tracks;
+}
+
+std::string BridgePayloads::PlaylistId(int index) const {
+    return playlistTemplateId + "-" + std::to_string(index);
+}
+
+std::string BridgePayloads::PlaylistTitle(int index) const {
+    return playlistTemplateTitle + " " + std::to_string(index);
+}
+
+std::string BridgePayloads::TracksJson(const std::vector<StubTrack>& tracks) const {
+    std::string out = "[";
+    for (size_t i = 0; i < tracks.size(); i++) {
+        if (i) out += ',';
+        AppendTrackJson(out, tracks[i]);
+    }
+    return out + "]";
+}
+
+std::string BridgePayloads::PlaylistPageJson(const std::vector<StubTrack>& tracks, int total, int offset, int limit) const {
+    return "{\"total\":" + std::to_string(total) + ",\"offset\":" + std::to_string(offset) +
+        ",\"limit\":" + std::to_string(limit) + ",\"tracks\":" + TracksJson(tracks) + "}";
+}
+
+std::string BridgePayloads::PlaylistsJson(int count, int tracksEach) const {
+    std::string out = "[";
+    for (int i = 0; i < count; i++) {
+        if (i) out += ',';
+        out += "{\"playlistId\":" + JsonEscape(PlaylistId(i)) + ",\"title\":" + JsonEscape(PlaylistTitle(i)) +
+            ",\"count\":" + std::to_string(tracksEach) +
+            ",\"thumbnail\":" + JsonEscape(mediaBase + "/vi/" + PlaylistId(i) + "/hqdefault.jpg") + "}";
+    }
+    return out + "]";
+}
+
+std::string BridgePayloads::StreamUrlJson(const std::string& videoId) const {
+    return "{\"videoId\":" + JsonEscape(videoId) +
+        ",\"streamUrl\":" + JsonEscape(mediaBase + "/media/" + videoId + "." + streamExt) +
+        ",\"title\":" + JsonEscape(videoId) + ",\"ext\":" + JsonEscape(streamExt) +
+        ",\"ttl\":" + std::to_string(streamTtl) + "}";
+}
+
+std::string BridgePayloads::StreamUrlsJson(const std::vector<std::string>& ids) const {
+    std::string out = "{\"results\":[";
+    for (size_t i = 0; i < ids.size(); i++) {
+        if (i) out += ',';
+        out += StreamUrlJson(ids[i]);
+    }
+    return out + "]}";
+}
+
+std::string BridgePayloads::ErrorJson() const {
+    return "{\"detail\":" + JsonEscape(errorDetail) + "}";
+}
+
+std::string BridgePayloads::TracksRecords(const std::vector<StubTrack>& tracks, uint32_t total) const {
+    std::string out;
+    PutRecordHeader(out, 1, total, (uint32_t)tracks.size());
+    for (const StubTrack& track : tracks) {
+        PutString(out, track.videoId);
+        PutString(out, track.title);
+        PutString(out, track.artist);
+        PutString(out, track.album);
+        PutString(out, track.thumbnail);
+        PutU32(out, (uint32_t)track.duration);
+        PutU8(out, track.isVideo ? 1 : 0);
+    }
+    return out;
+}
+
+std::string BridgePayloads::PlaylistsRecords(int count, int tracksEach) const {
+    std::string out;
+    PutRecordHeader(out, 2, 0xFFFFFFFFu, (uint32_t)count);
+    for (int i = 0; i < count; i++) {
+        PutString(out, PlaylistId(i));
+        PutString(out, PlaylistTitle(i));
+        PutString(out, mediaBase + "/vi/" + PlaylistId(i) + "/hqdefault.jpg");
+        PutU32(out, (uint32_t)tracksEach);
+    }
+    return out;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// StubBridge
+
+StubBridge::StubBridge(const StubBridgeOptions& options) : options(options), port(0) {
+    media.resize((size_t)options.mediaBytes);
+    for (size_t i = 0; i < media.size(); i++) media[i] = (char)(i * 31 + 7);
+}
+
+StubBridge::~StubBridge() {
+    Stop();
+}
+
+bool StubBridge::Start(std::string& error) {
+    if (!payloads.Load(options.examplesPath, error)) return false;
+
+    int tcp = socket(AF_INET, SOCK_STREAM, 0);
+    int yes = 1;
+    setsockopt(tcp, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+    sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t length = sizeof(address);
+    if (tcp < 0 || bind(tcp, (sockaddr*)&address, sizeof(address)) != 0 || listen(tcp, 64) != 0 ||
+        getsockname(tcp, (sockaddr*)&address, &length) != 0) {
+        error = std::string("cannot listen on 127.0.0.1: ") + strerror(errno);
+        if (tcp >= 0) close(tcp);
+        return false;
+    }
+    port = ntohs(address.sin_port);
+    listeners.push_back(tcp);
+    payloads.SetMediaBase(BaseUrl());
+
+    if (!options.socketPath.empty()) {
+        int unixSocket = socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un local;
+        memset(&local, 0, sizeof(local));
+        local.sun_family = AF_UNIX;
+        strncpy(local.sun_path, options.socketPath.c_str(), sizeof(local.sun_path) - 1);
+        unlink(options.socketPath.c_str());
+        if (unixSocket < 0 || bind(unixSocket, (sockaddr*)&local, sizeof(local)) != 0 || listen(unixSocket, 64) != 0) {
+            error = "cannot listen on " + options.socketPath + ": " + strerror(errno);
+            if (unixSocket >= 0) close(unixSocket);
+            Stop();
+            return false;
+        }
+        listeners.push_back(unixSocket);
+    }
+
+    running = true;
+    for (int listener : listeners) acceptThreads.emplace_back(&StubBridge::AcceptLoop, this, listener);
+    return true;
+}
+
+void StubBridge::Stop() {
+    running = false;
+    for (auto& thread : acceptThreads) thread.join();
+    acceptThreads.clear();
+    for (int listener : listeners) close(listener);
+    listeners.clear();
+    if (!options.socketPath.empty()) unlink(options.socketPath.c_str());
+
+    // Wake connection threads blocked in recv() and wait for them to leave
+    std::unique_lock<std::mutex> lock(connectionsMutex);
+    for (int fd : connections) shutdown(fd, SHUT_RDWR);
+    connectionsClosed.wait(lock, [this] { return connections.empty(); });
+}
+
+void StubBridge::AcceptLoop(int listener) {
+    while (running) {
+        pollfd waitFor = { listener, POLLIN, 0 };
+        if (poll(&waitFor, 1, 50) <= 0) continue;
+        int fd = accept(listener, nullptr, nullptr);
+        if (fd < 0) continue;
+        int yes = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));    // fails harmlessly on Unix sockets
+        std::lock_guard<std::mutex> lock(connectionsMutex);
+        connections.insert(fd);
+        std::thread(&StubBridge::ServeConnection, this, fd).detach();
+    }
+}
+
+void StubBridge::ServeConnection(int fd) {
+    std::string buffer;
+    char chunk[4096];
+    bool open = true;
+    while (open && running) {
+        size_t headerEnd;
+        while ((headerEnd = buffer.find("\r\n\r\n")) == std::string::npos) {
+            ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+            if (n <= 0) { open = false; break; }
+            buffer.append(chunk, (size_t)n);
+        }
+        if (!open) break;
+
+        Request request;
+        std::istringstream head(buffer.substr(0, headerEnd));
+        buffer.erase(0, headerEnd + 4);
+        std::string line, target, version;
+        std::getline(head, line);
+        std::istringstream requestLine(line);
+        requestLine >> request.method >> target >> version;
+        size_t question = target.find('?');
+        request.path = target.substr(0, question);
+        request.query = question == std::string::npos ? std::string() : target.substr(question + 1);
+        request.keepAlive = version == "HTTP/1.1";
+        while (std::getline(head, line)) {
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            size_t colon = line.find(':');
+            if (colon == std::string::npos) continue;
+            std::string name = line.substr(0, colon);
+            for (char& c : name) c = (char)tolower((unsigned char)c);
+            size_t start = line.find_first_not_of(' ', colon + 1);
+            std::string value = start == std::string::npos ? std::string() : line.substr(start);
+            if (name == "accept") request.accept = value;
+            else if (name == "if-none-match") request.ifNoneMatch = value;
+            else if (name == "range") request.range = value;
+            else if (name == "connection") request.keepAlive = value != "close";
+        }
+        requests++;
+        open = Respond(fd, request) && request.keepAlive;
+    }
+
+    std::lock_guard<std::mutex> lock(connectionsMutex);
+    close(fd);
+    connections.erase(fd);
+    connectionsClosed.notify_all();
+}
+
+bool StubBridge::Send(int fd, int status, const std::string& contentType, const std::string& body,
+                      const std::string& extraHeaders, bool keepAlive) {
+    std::string response = "HTTP/1.1 " + std::to_string(status) + " " + Reason(status) + "\r\n";
+    if (!contentType.empty()) response += "Content-Type: " + contentType + "\r\n";
+    response += "Content-Length: " + std::to_string(body.size()) + "\r\n" + extraHeaders;
+    response += keepAlive ? "Connection: keep-alive\r\n\r\n" : "Connection: close\r\n\r\n";
+    response += body;
+    size_t sent = 0;
+    while (sent < response.size()) {
+        ssize_t n = send(fd, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) return false;
+        sent += (size_t)n;
+    }
+    return true;
+}
+
+bool StubBridge::Respond(int fd, const Request& request) {
+    const std::string& path = request.path;
+    bool keepAlive = request.keepAlive;
+
+    // Media host: the file behind every stream URL, with Range support
+    if (path.compare(0, 7, "/media/") == 0) {
+        size_t first = 0, last = media.size() - 1;
+        if (request.range.compare(0, 6, "bytes=") == 0) {
+            char* dash = nullptr;
+            first = strtoul(request.range.c_str() + 6, &dash, 10);
+            if (dash && *dash == '-' && dash[1]) last = std::min(last, (size_t)strtoul(dash + 1, nullptr, 10));
+            if (first > last) return Send(fd, 416, "", "", "Content-Range: bytes */" + std::to_string(media.size()) + "\r\n", keepAlive);
+            return Send(fd, 206, "audio/mp4", media.substr(first, last - first + 1),
+                "Accept-Ranges: bytes\r\nContent-Range: bytes " + std::to_string(first) + "-" +
+                std::to_string(last) + "/" + std::to_string(media.size()) + "\r\n", keepAlive);
+        }
+        return Send(fd, 200, "audio/mp4", media, "Accept-Ranges: bytes\r\n", keepAlive);
+    }
+    // Image host: a small placeholder for every cover
+    if (path.compare(0, 4, "/vi/") == 0) {
+        static const std::string image = std::string("\xFF\xD8\xFF\xE0", 4) + std::string(2044, 'j');
+        return Send(fd, 200, "image/jpeg", image, "", keepAlive);
+    }
+
+    if (options.latencyMs > 0) std::this_thread::sleep_for(std::chrono::milliseconds(options.latencyMs));
+    bool records = request.accept.find(BridgePayloads::RecordsContentType()) != std::string::npos;
+    const char* json = "application/json";
+
+    if (path == "/") return Send(fd, 200, json, payloads.Health(), "", keepAlive);
+    if (path == "/auth_status") return Send(fd, 200, json, "{\"authenticated\":true}", "", keepAlive);
+
+    if (path == "/search") {
+        std::vector<StubTrack> tracks = payloads.Tracks(QueryParam(request.query, "q"), 0, options.searchResults);
+        if (records) return Send(fd, 200, BridgePayloads::RecordsContentType(), payloads.TracksRecords(tracks, 0xFFFFFFFFu), "", keepAlive);
+        return Send(fd, 200, json, payloads.TracksJson(tracks), "", keepAlive);
+    }
+
+    if (path == "/get_url") {
+        std::string id = QueryParam(request.query, "id");
+        if (id.empty() || id == "INVALID") return Send(fd, 404, json, payloads.ErrorJson(), "", keepAlive);
+        return Send(fd, 200, json, payloads.StreamUrlJson(id), "", keepAlive);
+    }
+
+    if (path == "/get_urls") {
+        std::vector<std::string> ids;
+        std::istringstream list(QueryParam(request.query, "ids"));
+        std::string id;
+        while (std::getline(list, id, ',')) if (!id.empty()) ids.push_back(id);
+        return Send(fd, 200, json, payloads.StreamUrlsJson(ids), "", keepAlive);
+    }
+
+    // The stub's playlists never change, so one ETag versions everything
+    if (path == "/playlists") {
+        std::string etag = "\"playlists-1\"";
+        if (request.ifNoneMatch == etag) return Send(fd, 304, "", "", "ETag: " + etag + "\r\n", keepAlive);
+        std::string headers = "ETag: " + etag + "\r\n";
+        if (records) return Send(fd, 200, BridgePayloads::RecordsContentType(), payloads.PlaylistsRecords(options.playlists, options.playlistTracks), headers, keepAlive);
+        return Send(fd, 200, json, payloads.PlaylistsJson(options.playlists, options.playlistTracks), headers, keepAlive);
+    }
+
+    if (path == "/playlist_tracks" || path == "/playlist_delta") {
+        std::string id = QueryParam(request.query, "id");
+        std::string etag = "\"" + id + "-snapshot-1\"";
+        if (path == "/playlist_delta") {
+            // Unchanged since the snapshot the plugin has, else "too old"
+            if (QueryParam(request.query, "since") == etag) return Send(fd, 304, "", "", "ETag: " + etag + "\r\n", keepAlive);
+            return Send(fd, 409, json, "{\"detail\":\"unknown snapshot\"}", "", keepAlive);
+        }
+        if (request.ifNoneMatch == etag) return Send(fd, 304, "", "", "ETag: " + etag + "\r\n", keepAlive);
+        int total = options.playlistTracks;
+        int offset = std::max(0, std::min(total, atoi(QueryParam(request.query, "offset").c_str())));
+        std::string limitParam = QueryParam(request.query, "limit");
+        int limit = limitParam.empty() ? total : std::max(0, atoi(limitParam.c_str()));
+        std::vector<StubTrack> tracks = payloads.Tracks(id, offset, std::min(limit, total - offset));
+        std::string headers = "ETag: " + etag + "\r\n";
+        if (records) return Send(fd, 200, BridgePayloads::RecordsContentType(), payloads.TracksRecords(tracks, (uint32_t)total), headers, keepAlive);
+        return Send(fd, 200, json, payloads.PlaylistPageJson(tracks, total, offset, limit), headers, keepAlive);
+    }
+
+    return Send(fd, 404, json, "{\"detail\":\"Not Found\"}", "", keepAlive);
+}
+
+}
@@ -0,0 +1,130 @@
+//////////////////////////////////////////////////////////////////////////
+// StubBridge - an in-process stand-in for the bridge, for the benchmarks.
+// Serves the endpoints of bridge_api_examples.json over TCP (127.0.0.1,
+// any free port) and optionally a Unix domain socket, with the example
+// payloads scaled up to the requested sizes. It behaves like a well-made
+// bridge: keep-alive, ETags with 304s, the record format when the Accept
+// header offers it, and a local media/thumbnail host so nothing leaves the
+// machine.
+
+#ifndef BENCH_STUB_BRIDGE_H
+#define BENCH_STUB_BRIDGE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace bench {
+
+struct StubTrack {
+    std::string videoId;
+    std::string title;
+    std::string artist;
+    std::string album;
+    std::string thumbnail;
+    int duration;
+    bool isVideo;
+};
+
+//////////////////////////////////////////////////////////////////////////
+// BridgePayloads - response bodies built from the examples. Every track
+// gets an id derived from its seed (query or playlist) and position, so
+// results never collide in the plugin's caches.
+class BridgePayloads {
+private:
+    std::string health;
+    std::vector<StubTrack> trackTemplates;
+    std::string playlistTemplateId;
+    std::string playlistTemplateTitle;
+    std::string streamExt;
+    int streamTtl;
+    std::string errorDetail;
+    std::string mediaBase;      // "http://127.0.0.1:port", for thumbnails and stream URLs
+
+public:
+    BridgePayloads() : streamTtl(0) {}
+
+    // Read the templates from bridge_api_examples.json
+    bool Load(const std::string& examplesPath, std::string& error);
+    void SetMediaBase(const std::string& baseUrl) { mediaBase = baseUrl; }
+
+    std::vector<StubTrack> Tracks(const std::string& seed, int offset, int count) const;
+    std::string PlaylistId(int index) const;
+    std::string PlaylistTitle(int index) const;
+
+    const std::string& Health() const { return health; }
+    std::string TracksJson(const std::vector<StubTrack>& tracks) const;
+    std::string PlaylistPageJson(const std::vector<StubTrack>& tracks, int total, int offset, int limit) const;
+    std::string PlaylistsJson(int count, int tracksEach) const;
+    std::string StreamUrlJson(const std::string& videoId) const;
+    std::string StreamUrlsJson(const std::vector<std::string>& ids) const;
+    std::string ErrorJson() const;
+
+    // application/x-ytm-records bodies (section 8 of the examples)
+    static const char* RecordsContentType() { return "application/x-ytm-records"; }
+    std::string TracksRecords(const std::vector<StubTrack>& tracks, uint32_t total) const;
+    std::string PlaylistsRecords(int count, int tracksEach) const;
+};
+
+struct StubBridgeOptions {
+    std::string examplesPath;       // bridge_api_examples.json
+    std::string socketPath;         // also listen on this Unix socket (empty = TCP only)
+    int latencyMs = 0;              // added to every API response (not media or thumbnails)
+    int searchResults = 50;         // tracks per /search
+    int playlists = 16;             // entries in /playlists
+    int playlistTracks = 1000;      // tracks per playlist
+    int mediaBytes = 256 * 1024;    // size of the audio file behind every stream URL
+};
+
+class StubBridge {
+private:
+    struct Request {
+        std::string method;
+        std::string path;
+        std::string query;
+        std::string accept;
+        std::string ifNoneMatch;
+        std::string range;
+        bool keepAlive;
+    };
+
+    StubBridgeOptions options;
+    BridgePayloads payloads;
+    std::string media;
+    int port;
+    std::vector<int> listeners;
+    std::vector<std::thread> acceptThreads;
+    std::atomic<bool> running{false};
+    std::atomic<uint64_t> requests{0};
+    std::mutex connectionsMutex;
+    std::condition_variable connectionsClosed;
+    std::set<int> connections;
+
+    void AcceptLoop(int listener);
+    void ServeConnection(int fd);
+    // Writes the response; returns false if the connection should close
+    bool Respond(int fd, const Request& request);
+    bool Send(int fd, int status, const std::string& contentType, const std::string& body,
+              const std::string& extraHeaders, bool keepAlive);
+
+public:
+    explicit StubBridge(const StubBridgeOptions& options);
+    ~StubBridge();
+
+    bool Start(std::string& error);
+    void Stop();
+
+    int Port() const { return port; }
+    std::string BaseUrl() const { return "http://127.0.0.1:" + std::to_string(port); }
+    const BridgePayloads& Payloads() const { return payloads; }
+    uint64_t Requests() const { return requests.load(); }
+};
+
+}
+
+#endif
@@ -0,0 +1,104 @@
+//////////////////////////////////////////////////////////////////////////
+// VdjHost - loads the plugin the way VirtualDJ does (DllGetClassObject,
+// OnGetPluginInfo, OnLoad, Release at the end) and hands out the online
+// source interface, plus mocks of the lists and strings VirtualDJ passes in.
+
+#ifndef BENCH_VDJ_HOST_H
+#define BENCH_VDJ_HOST_H
+
+#include "../sdk/vdjPlugin8.h"
+#include "../sdk/vdjOnlineSource.h"
+
+#include <cstring>
+
+extern "C" HRESULT VDJ_API DllGetClassObject(const GUID& rclsid, const GUID& riid, void** ppObject);
+
+namespace bench {
+
+class VdjHost {
+private:
+    IVdjPluginOnlineSource* plugin;
+    TVdjPluginInfo8 info;
+
+public:
+    VdjHost() : plugin(nullptr), info() {}
+    ~VdjHost() { Unload(); }
+
+    bool Load() {
+        void* object = nullptr;
+        if (DllGetClassObject(CLSID_VdjPlugin8, IID_IVdjPluginOnlineSource, &object) != NO_ERROR || !object)
+            return false;
+        plugin = static_cast<IVdjPluginOnlineSource*>(object);
+        if (plugin->OnGetPluginInfo(&info) != S_OK) return false;
+        return plugin->OnLoad() == S_OK;
+    }
+
+    void Unload() {
+        if (plugin) plugin->Release();
+        plugin = nullptr;
+    }
+
+    const TVdjPluginInfo8& Info() const { return info; }
+    IVdjPluginOnlineSource* operator->() const { return plugin; }
+};
+
+// Reads every field of every row, as VirtualDJ copies them into its
+// browser, without allocating so the plugin's allocations stay measurable
+class MockTracksList : public IVdjTracksList {
+private:
+    size_t rows;
+    size_t bytes;
+
+    static size_t Length(const char* s) { return s ? strlen(s) : 0; }
+
+public:
+    MockTracksList() : rows(0), bytes(0) {}
+
+    void add(const char* uniqueId, const char* title, const char* artist, const char* remix,
+             const char* genre, const char* label, const char* comment, const char* coverUrl,
+             const char* streamUrl, float length, float bpm, int key, int year,
+             bool isVideo, bool isKaraoke) override {
+        (void)length; (void)bpm; (void)key; (void)year; (void)isVideo; (void)isKaraoke;
+        rows++;
+        bytes += Length(uniqueId) + Length(title) + Length(artist) + Length(remix) + Length(genre) +
+            Length(label) + Length(comment) + Length(coverUrl) + Length(streamUrl);
+    }
+
+    size_t Rows() const { return rows; }
+    size_t Bytes() const { return bytes; }
+};
+
+class MockString : public IVdjString {
+private:
+    char value[4096];
+
+public:
+    MockString() { value[0] = 0; }
+
+    IVdjString& operator=(const char* text) override {
+        strncpy(value, text ? text : "", sizeof(value) - 1);
+        value[sizeof(value) - 1] = 0;
+        return *this;
+    }
+
+    const char* Get() const { return value; }
+};
+
+class MockSubfoldersList : public IVdjSubfoldersList {
+private:
+    size_t folders;
+
+public:
+    MockSubfoldersList() : folders(0) {}
+
+    void add(const char* folderUniqueId, const char* folderName) override {
+        (void)folderUniqueId; (void)folderName;
+        folders++;
+    }
+
+    size_t Folders() const { return folders; }
+};
+
+}
+
+#endif
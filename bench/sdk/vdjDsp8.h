@@ -0,0 +1,12 @@
+//////////////////////////////////////////////////////////////////////////
+// Stand-in for the VirtualDJ 8 DSP interface ids (see vdjPlugin8.h)
+
+#ifndef VDJDSP8_H
+#define VDJDSP8_H
+
+#include "vdjPlugin8.h"
+
+static const GUID IID_IVdjPluginDsp8 = { 0x76a1b9a0, 0x0004, 0x4b1a, { 0x8f, 0x10, 0, 0, 0, 0, 0, 0x04 } };
+static const GUID IID_IVdjPluginBuffer8 = { 0x76a1b9a0, 0x0005, 0x4b1a, { 0x8f, 0x10, 0, 0, 0, 0, 0, 0x05 } };
+
+#endif
@@ -0,0 +1,38 @@
+//////////////////////////////////////////////////////////////////////////
+// Stand-in for the VirtualDJ 8 online source interface (see vdjPlugin8.h)
+
+#ifndef VDJONLINESOURCE_H
+#define VDJONLINESOURCE_H
+
+#include "vdjPlugin8.h"
+
+static const GUID IID_IVdjPluginOnlineSource = { 0x76a1b9a0, 0x0003, 0x4b1a, { 0x8f, 0x10, 0, 0, 0, 0, 0, 0x03 } };
+
+class IVdjString {
+public:
+    virtual IVdjString& operator=(const char* value) = 0;
+};
+
+class IVdjTracksList {
+public:
+    virtual void add(const char* uniqueId, const char* title, const char* artist, const char* remix,
+                     const char* genre, const char* label, const char* comment, const char* coverUrl,
+                     const char* streamUrl, float length, float bpm, int key, int year,
+                     bool isVideo, bool isKaraoke) = 0;
+};
+
+class IVdjSubfoldersList {
+public:
+    virtual void add(const char* folderUniqueId, const char* folderName) = 0;
+};
+
+class IVdjPluginOnlineSource : public IVdjPlugin8 {
+public:
+    virtual HRESULT VDJ_API OnSearch(const char* search, IVdjTracksList* tracksList) { return E_NOTIMPL; }
+    virtual HRESULT VDJ_API OnSearchCancel() { return E_NOTIMPL; }
+    virtual HRESULT VDJ_API GetStreamUrl(const char* uniqueId, IVdjString& url, IVdjString& errorMessage) { return E_NOTIMPL; }
+    virtual HRESULT VDJ_API GetFolderList(IVdjSubfoldersList* subfoldersList) { return E_NOTIMPL; }
+    virtual HRESULT VDJ_API GetFolder(const char* folderUniqueId, IVdjTracksList* tracksList) { return E_NOTIMPL; }
+};
+
+#endif
@@ -0,0 +1,52 @@
+//////////////////////////////////////////////////////////////////////////
+// Stand-in for the VirtualDJ 8 SDK header, for building the plugin on Linux
+// in the benchmarks. Declares only what YouTubeMusicPlugin.cpp uses, with
+// the SDK's names and signatures. GUID values are placeholders; they only
+// need to differ from each other.
+
+#ifndef VDJPLUGIN8_H
+#define VDJPLUGIN8_H
+
+#include <cstddef>
+
+typedef long HRESULT;
+typedef void* HANDLE;
+
+#define S_OK ((HRESULT)0L)
+#define S_FALSE ((HRESULT)1L)
+#define E_NOTIMPL ((HRESULT)0x80004001L)
+#define E_FAIL ((HRESULT)0x80004005L)
+#define NO_ERROR 0L
+#define CLASS_E_CLASSNOTAVAILABLE ((HRESULT)0x80040111L)
+
+#define VDJ_API
+#define VDJ_EXPORT __attribute__((visibility("default")))
+
+struct GUID {
+    unsigned int Data1;
+    unsigned short Data2;
+    unsigned short Data3;
+    unsigned char Data4[8];
+};
+
+static const GUID CLSID_VdjPlugin8 = { 0x76a1b9a0, 0x0001, 0x4b1a, { 0x8f, 0x10, 0, 0, 0, 0, 0, 0x01 } };
+static const GUID IID_IVdjPluginBasic8 = { 0x76a1b9a0, 0x0002, 0x4b1a, { 0x8f, 0x10, 0, 0, 0, 0, 0, 0x02 } };
+
+struct TVdjPluginInfo8 {
+    const char* PluginName;
+    const char* Author;
+    const char* Description;
+    const char* Version;
+    void* Bitmap;
+    unsigned int Flags;
+};
+
+class IVdjPlugin8 {
+public:
+    virtual ~IVdjPlugin8() {}
+    virtual HRESULT VDJ_API OnLoad() { return S_OK; }
+    virtual HRESULT VDJ_API OnGetPluginInfo(TVdjPluginInfo8* infos) { return E_NOTIMPL; }
+    virtual unsigned long VDJ_API Release() { delete this; return 0; }
+};
+
+#endif
@@ -0,0 +1,13 @@
+//////////////////////////////////////////////////////////////////////////
+// Stand-in for the VirtualDJ 8 video interface ids (see vdjPlugin8.h)
+
+#ifndef VDJVIDEO8_H
+#define VDJVIDEO8_H
+
+#include "vdjPlugin8.h"
+
+static const GUID IID_IVdjPluginVideoFx8 = { 0x76a1b9a0, 0x0006, 0x4b1a, { 0x8f, 0x10, 0, 0, 0, 0, 0, 0x06 } };
+static const GUID IID_IVdjPluginVideoTransition8 = { 0x76a1b9a0, 0x0007, 0x4b1a, { 0x8f, 0x10, 0, 0, 0, 0, 0, 0x07 } };
+static const GUID IID_IVdjPluginVideoTransitionMultiDeck8 = { 0x76a1b9a0, 0x0008, 0x4b1a, { 0x8f, 0x10, 0, 0, 0, 0, 0, 0x08 } };
+
+#endif
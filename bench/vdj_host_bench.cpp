@@ -0,0 +1,201 @@
+//////////////////////////////////////////////////////////////////////////
+// vdj_host_bench - drives the plugin headless, the way VirtualDJ does,
+// against the stub bridge, and reports per-call latency (p50/p95/p99/max),
+// heap allocations per call and throughput with several decks loading at
+// once. Allocations are those of the calling (VirtualDJ) thread; work the
+// plugin hands to its own threads is not counted.
+//
+//   vdj_host_bench [--iterations N] [--decks N] [--latency-ms N] [--results N]
+//                  [--playlist-tracks N] [--log-level N] [--unix-socket]
+
+#include "host/bench_stats.h"
+#include "host/plugin_settings.h"
+#include "host/stub_bridge.h"
+#include "host/vdj_host.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <thread>
+#include <vector>
+
+#ifndef BRIDGE_EXAMPLES
+#define BRIDGE_EXAMPLES "bridge_api_examples.json"
+#endif
+
+using namespace bench;
+
+namespace {
+
+struct Options {
+    int iterations = 200;
+    int decks = 4;
+    int latencyMs = 5;
+    int results = 50;
+    int playlistTracks = 1000;
+    int logLevel = 1;
+    bool unixSocket = false;
+};
+
+bool ParseArgs(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--unix-socket") options.unixSocket = true;
+        else if (arg == "--iterations" && hasValue) options.iterations = atoi(argv[++i]);
+        else if (arg == "--decks" && hasValue) options.decks = atoi(argv[++i]);
+        else if (arg == "--latency-ms" && hasValue) options.latencyMs = atoi(argv[++i]);
+        else if (arg == "--results" && hasValue) options.results = atoi(argv[++i]);
+        else if (arg == "--playlist-tracks" && hasValue) options.playlistTracks = atoi(argv[++i]);
+        else if (arg == "--log-level" && hasValue) options.logLevel = atoi(argv[++i]);
+        else return false;
+    }
+    return options.iterations > 0 && options.decks > 0;
+}
+
+// Poll until ready() or the timeout; used to wait for background work the
+// next scenario depends on
+template <class Ready>
+bool WaitFor(Ready ready, int timeoutMs) {
+    for (int waited = 0; waited < timeoutMs; waited += 10) {
+        if (ready()) return true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return ready();
+}
+
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!ParseArgs(argc, argv, options)) {
+        fprintf(stderr, "usage: %s [--iterations N] [--decks N] [--latency-ms N] [--results N]"
+            " [--playlist-tracks N] [--log-level N] [--unix-socket]\n", argv[0]);
+        return 2;
+    }
+
+    // Fresh data folder (plugin.log, caches) for every run
+    char dataTemplate[] = "/tmp/vdj_host_bench.XXXXXX";
+    if (!mkdtemp(dataTemplate)) {
+        perror("mkdtemp");
+        return 1;
+    }
+    std::string dataDir = dataTemplate;
+
+    StubBridgeOptions bridgeOptions;
+    bridgeOptions.examplesPath = BRIDGE_EXAMPLES;
+    bridgeOptions.latencyMs = options.latencyMs;
+    bridgeOptions.searchResults = options.results;
+    bridgeOptions.playlists = options.iterations;
+    bridgeOptions.playlistTracks = options.playlistTracks;
+    if (options.unixSocket) bridgeOptions.socketPath = dataDir + "/bridge.sock";
+    StubBridge bridge(bridgeOptions);
+    std::string error;
+    if (!bridge.Start(error)) {
+        fprintf(stderr, "stub bridge: %s\n", error.c_str());
+        return 1;
+    }
+
+    BPath = dataDir;
+    BridgePort = bridge.Port();
+    BridgeSocketPath = bridgeOptions.socketPath;
+    LogLevel = options.logLevel;
+    SearchDebounceMs = 0;           // the host sends whole queries, not keystrokes
+    PlaylistWarmup = false;         // so first opens are cold
+    MetricsExportSeconds = 0;
+
+    VdjHost host;
+    Clock::time_point loadStart = Clock::now();
+    if (!host.Load()) {
+        fprintf(stderr, "plugin failed to load\n");
+        return 1;
+    }
+    printf("%s %s, bridge over %s, %d ms bridge latency, %d results per search, %d tracks per playlist\n",
+        host.Info().PluginName, host.Info().Version, options.unixSocket ? "unix socket" : "tcp",
+        options.latencyMs, options.results, options.playlistTracks);
+    printf("OnLoad: %.1f ms\n\n", MicrosecondsSince(loadStart) / 1000);
+    LatencyStats::PrintHeader();
+
+    uint64_t failures = 0;
+    auto report = [&failures](const std::string& name, const LatencyStats& stats) {
+        stats.Print(name);
+        failures += stats.Failures();
+    };
+
+    report("OnSearch (new query)", Measure(options.iterations, [&](int i) {
+        MockTracksList list;
+        std::string query = "bench query " + std::to_string(i);
+        return host->OnSearch(query.c_str(), &list) == S_OK && list.Rows() > 0;
+    }));
+
+    report("OnSearch (repeated query)", Measure(options.iterations, [&](int) {
+        MockTracksList list;
+        return host->OnSearch("bench query 0", &list) == S_OK && list.Rows() > 0;
+    }));
+
+    // The first call starts the background refresh of the list
+    MockSubfoldersList firstList;
+    host->GetFolderList(&firstList);
+    WaitFor([&] {
+        MockSubfoldersList list;
+        host->GetFolderList(&list);
+        return list.Folders() == (size_t)options.iterations;
+    }, 10000);
+
+    report("GetFolderList", Measure(options.iterations, [&](int) {
+        MockSubfoldersList list;
+        return host->GetFolderList(&list) == S_OK && list.Folders() > 0;
+    }));
+
+    report("GetFolder (first open)", Measure(options.iterations, [&](int i) {
+        MockTracksList list;
+        std::string id = bridge.Payloads().PlaylistId(i);
+        return host->GetFolder(id.c_str(), &list) == S_OK && list.Rows() > 0;
+    }));
+
+    // The last few opened are still in the plugin's memory once loaded
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    report("GetFolder (reopen)", Measure(options.iterations, [&](int i) {
+        MockTracksList list;
+        std::string id = bridge.Payloads().PlaylistId(options.iterations - 1 - i % 4);
+        return host->GetFolder(id.c_str(), &list) == S_OK && list.Rows() > 0;
+    }));
+
+    report("GetStreamUrl (new track)", Measure(options.iterations, [&](int i) {
+        MockString url, message;
+        std::string id = "deck-" + std::to_string(i);
+        return host->GetStreamUrl(id.c_str(), url, message) == S_OK && url.Get()[0];
+    }));
+
+    report("GetStreamUrl (loaded before)", Measure(options.iterations, [&](int) {
+        MockString url, message;
+        return host->GetStreamUrl("deck-0", url, message) == S_OK && url.Get()[0];
+    }));
+
+    // Every deck loads new tracks at the same time
+    std::vector<LatencyStats> perDeck((size_t)options.decks);
+    std::vector<std::thread> decks;
+    Clock::time_point concurrentStart = Clock::now();
+    for (int d = 0; d < options.decks; d++) {
+        decks.emplace_back([&, d] {
+            perDeck[(size_t)d] = Measure(options.iterations, [&](int i) {
+                MockString url, message;
+                std::string id = "deck" + std::to_string(d) + "-" + std::to_string(i);
+                return host->GetStreamUrl(id.c_str(), url, message) == S_OK && url.Get()[0];
+            });
+        });
+    }
+    for (auto& deck : decks) deck.join();
+    LatencyStats concurrent;
+    for (const auto& stats : perDeck) concurrent.Merge(stats);
+    concurrent.SetWallSeconds(MicrosecondsSince(concurrentStart) / 1e6);
+    report("GetStreamUrl (" + std::to_string(options.decks) + " decks)", concurrent);
+
+    host.Unload();
+    bridge.Stop();
+    printf("\n%llu bridge requests\n", (unsigned long long)bridge.Requests());
+    std::error_code ignored;
+    std::filesystem::remove_all(dataDir, ignored);
+    return failures ? 1 : 0;
+}